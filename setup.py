@@ -1,16 +1,60 @@
 from setuptools import setup, Extension, find_packages
 from setuptools.command.install import install
+from setuptools.command.sdist import sdist
 from distutils.command.build import build
+from distutils.dep_util import newer
 import numpy
 import os
 
+base_dir = os.path.dirname(__file__)
+
+# The bindings are generated from CVXcanon.i by SWIG. Source distributions
+# ship the generated CVXcanon_wrap.cpp and CVXcanon.py, so installing from
+# one does not need SWIG; a checkout regenerates them whenever CVXcanon.i
+# is newer.
+interface = 'src/python/CVXcanon.i'
+wrapper = 'src/python/CVXcanon_wrap.cpp'
+if os.path.exists(os.path.join(base_dir, wrapper)) and \
+   not newer(os.path.join(base_dir, interface), os.path.join(base_dir, wrapper)):
+    bindings = wrapper
+else:
+    bindings = interface
+
 canon = Extension(
     '_CVXcanon',
-    sources=['src/CVXcanon.cpp', 'src/LinOpOperations.cpp', 'src/python/CVXcanon_wrap.cpp'],
-    include_dirs=['src/', 'src/python/', 'include/Eigen', numpy.get_include()]
+    sources=['src/CVXcanon.cpp', 'src/LinOpOperations.cpp', 'src/LinOpForest.cpp',
+             'src/ProblemDataOperations.cpp', 'src/Presolve.cpp',
+             'src/Reorder.cpp', 'src/CVXcanonC.cpp',
+             'src/ThreadPool.cpp', 'src/ExecutionContext.cpp',
+             'src/MemoryResource.cpp', 'src/Spill.cpp',
+             bindings],
+    swig_opts=['-c++', '-Isrc', '-Isrc/python', '-outdir', 'src/python'],
+    include_dirs=['src/', 'src/python/', 'include/Eigen', numpy.get_include()],
+    extra_compile_args=['-std=c++11', '-pthread'],
+    extra_link_args=['-pthread']
 )
 
-base_dir = os.path.dirname(__file__)
+
+# SWIG writes CVXcanon.py while building the extension, so the extension
+# must be built before the Python modules are collected.
+class CustomBuild(build):
+    def run(self):
+        self.run_command('build_ext')
+        build.run(self)
+
+
+class CustomInstall(install):
+    def run(self):
+        self.run_command('build_ext')
+        install.run(self)
+
+
+class CustomSdist(sdist):
+    def run(self):
+        self.run_command('build_ext')
+        sdist.run(self)
+
+
 about = {}
 with open(os.path.join(base_dir, "src", "python", "_version__.py")) as f:
     exec(f.read(), about)
@@ -22,6 +66,8 @@ setup(
     author='Jack Zhu, John Miller, Paul Quigley',
     author_email='jackzhu@stanford.edu, millerjp@stanford.edu, piq93@stanford.edu',
     ext_modules=[canon],
+    cmdclass={'build': CustomBuild, 'install': CustomInstall,
+              'sdist': CustomSdist},
     package_dir={'': 'src/python'},
     py_modules=['canonInterface', 'CVXcanon', '_version__'],
     description='A low-level library to perform the matrix building step in cvxpy, a convex optimization modeling software.',
@@ -0,0 +1,74 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BUILDOPTIONS_H
+#define BUILDOPTIONS_H
+
+#include <string>
+
+/* Optional stages of BUILD_MATRIX. The default values reproduce the plain
+ * build_matrix output. */
+class BuildOptions {
+public:
+	/* Sum duplicate (I, J) entries and sort V, I, J by column, then row.
+	 * See canonicalize in ProblemDataOperations.hpp. */
+	bool canonicalize;
+
+	/* If CANONICALIZE is set, entries with |v| <= ZERO_TOL after summing
+	 * duplicates are dropped. Zero drops explicit zeros only. */
+	double zero_tol;
+
+	/* Fill ProblemData::stats with per row and per column inf-norms,
+	 * two-norms and nonzero counts. The statistics are accumulated while the
+	 * entries are emitted, or after CANONICALIZE if that is set. */
+	bool compute_stats;
+
+	/* Apply one step of Ruiz equilibration to the output, scaling the
+	 * matrix and the constant vector in place. The scaling is returned in
+	 * ProblemData::stats. See equilibrate in ProblemDataOperations.hpp. */
+	bool equilibrate;
+
+	/* Return the constant vector as sorted index/value pairs in
+	 * ProblemData::const_idx and const_val instead of the dense CONST_VEC,
+	 * for problems with many rows and few nonzero constants. See
+	 * ProblemData::densify_const_vec. */
+	bool sparse_const_vec;
+
+	/* If positive, at most about this many bytes of V, I and J are held in
+	 * memory while the constraints are built. Finished constraints beyond
+	 * it are written to a temporary file, and at the end V, I and J are
+	 * assembled in memory mapped temporary files that the kernel can page
+	 * out, so models larger than RAM still finish. The later stages take
+	 * their temporary arrays from such files too. The dense CONST_VEC is
+	 * not covered, so problems with many rows should also set
+	 * SPARSE_CONST_VEC. If the disk runs out of space the build throws
+	 * std::bad_alloc or std::runtime_error. See TripletSpill in Spill.hpp. */
+	long memory_budget;
+
+	/* Directory of the temporary files of MEMORY_BUDGET. Empty selects
+	 * $TMPDIR, or /tmp. It should be on a disk rather than on tmpfs. */
+	std::string spill_dir;
+
+	BuildOptions() {
+		canonicalize = false;
+		zero_tol = 0;
+		compute_stats = false;
+		equilibrate = false;
+		sparse_const_vec = false;
+		memory_budget = 0;
+	}
+};
+
+#endif
@@ -14,11 +14,22 @@
 //    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "CVXcanon.hpp"
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include "LinOp.hpp"
 #include "LinOpOperations.hpp"
 #include "ProblemData.hpp"
+#include "ProblemDataOperations.hpp"
+#include "Parallel.hpp"
+#include "Spill.hpp"
 
 void mul_by_const(Matrix &coeff_mat,
         std::map<int, Matrix > &rh_coeffs,
@@ -50,8 +61,188 @@ void mul_by_const(Matrix &coeff_mat,
 	}
 }
 
-std::map<int, Matrix > get_coefficient(LinOp &lin){
+/* Memoizes the coefficients of LinOps with several parents within one build,
+	 so a subtree shared between constraints, the objective or the arguments of
+	 a single LinOp is only traversed once. Each entry is released once all of
+	 its parents have used it. Also holds the estimated cost of every subtree,
+	 which decides whether its arguments are evaluated in parallel. Safe to
+	 use from several threads: the first thread to look up a shared LinOp
+	 computes it, and the others wait for its result. */
+class CoeffCache {
+public:
+	/* Counts the parents of every LinOp reachable from ROOTS. A root counts as
+		 one use. */
+	CoeffCache(std::vector<LinOp*> &roots) {
+		std::vector<LinOp*> stack;
+		for (unsigned i = 0; i < roots.size(); i++) {
+			if (roots[i] != NULL && uses[roots[i]]++ == 0) {
+				stack.push_back(roots[i]);
+			}
+		}
+		while (!stack.empty()) {
+			LinOp *lin = stack.back();
+			stack.pop_back();
+			for (unsigned i = 0; i < lin->args.size(); i++) {
+				if (uses[lin->args[i]]++ == 0) {
+					stack.push_back(lin->args[i]);
+				}
+			}
+		}
+		compute_costs(roots);
+	}
+
+	/* Estimated work of computing the coefficients of LIN: the number of
+		 entries of every LinOp in its subtree */
+	long get_cost(LinOp *lin) const {
+		std::unordered_map<LinOp*, long>::const_iterator it = costs.find(lin);
+		return it == costs.end() ? 0 : it->second;
+	}
+
+	/* Moves the cached coefficients of LIN into COEFFS and returns true, or
+		 returns false if the caller must compute them and pass them to STORE.
+		 If another thread is computing LIN, waits for it to finish. Only the
+		 first lookup of a shared LinOp returns false. */
+	bool find(LinOp *lin, std::map<int, Matrix> &coeffs) {
+		std::unique_lock<std::mutex> lock(mutex);
+		std::unordered_map<LinOp*, int>::iterator use = uses.find(lin);
+		std::unordered_map<LinOp*, Entry>::iterator it = entries.find(lin);
+		if (it == entries.end()) {
+			/* Only LinOps with several parents are kept, in flight until
+			   STORE */
+			if (use != uses.end() && use->second > 1) {
+				entries[lin].ready = false;
+			}
+			return false;
+		}
+		Entry &entry = it->second;
+		computed.wait(lock, [&entry]() { return entry.ready; });
+		if (--use->second == 0) {
+			coeffs = std::move(entry.coeffs);
+			entries.erase(it);
+		} else {
+			coeffs = entry.coeffs;
+		}
+		return true;
+	}
+
+	/* Keeps COEFFS of LIN for its remaining parents and wakes the threads
+		 waiting for them */
+	void store(LinOp *lin, std::map<int, Matrix> &coeffs) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unordered_map<LinOp*, Entry>::iterator it = entries.find(lin);
+		if (it == entries.end()) {
+			return;
+		}
+		uses[lin]--;
+		it->second.coeffs = coeffs;
+		it->second.ready = true;
+		computed.notify_all();
+	}
+
+private:
+	/* Coefficients of a shared LinOp, which are being computed until READY
+		 is set */
+	struct Entry {
+		bool ready;
+		std::map<int, Matrix> coeffs;
+	};
+
+	std::unordered_map<LinOp*, int> uses;
+	std::unordered_map<LinOp*, Entry> entries;
+	std::unordered_map<LinOp*, long> costs;
+	std::mutex mutex;
+	std::condition_variable computed;
+
+	/* Fills COSTS bottom up. Shared subtrees count once per parent, and the
+		 costs saturate instead of overflowing. */
+	void compute_costs(std::vector<LinOp*> &roots) {
+		std::vector<std::pair<LinOp*, unsigned> > stack;
+		for (unsigned r = 0; r < roots.size(); r++) {
+			if (roots[r] == NULL || costs.count(roots[r])) {
+				continue;
+			}
+			stack.push_back(std::make_pair(roots[r], 0u));
+			while (!stack.empty()) {
+				LinOp *lin = stack.back().first;
+				unsigned next = stack.back().second;
+				if (next < lin->args.size()) {
+					stack.back().second++;
+					if (!costs.count(lin->args[next])) {
+						stack.push_back(std::make_pair(lin->args[next], 0u));
+					}
+					continue;
+				}
+				long cost = 1;
+				if (lin->size.size() >= 2) {
+					cost = std::max(1L, (long) lin->size[0] * lin->size[1]);
+				}
+				for (unsigned i = 0; i < lin->args.size(); i++) {
+					cost = std::min(LONG_MAX / 2, cost + costs[lin->args[i]]);
+				}
+				costs[lin] = cost;
+				stack.pop_back();
+			}
+		}
+	}
+};
+
+std::map<int, Matrix > get_coefficient(LinOp &lin, CoeffCache *cache);
+
+/* Returns the coefficients of argument I of LIN multiplied by the
+	 coefficient of LIN for that argument. If APPLY is set the coefficient is
+	 applied with APPLY_FUNC_COEFF, otherwise it is COEFF_MAT[I]. */
+std::map<int, Matrix > get_arg_contribution(LinOp &lin, unsigned i,
+                                            bool apply,
+                                            std::vector<Matrix> &coeff_mat,
+                                            CoeffCache *cache){
+	std::map<int, Matrix > rh_coeffs = get_coefficient(*lin.args[i], cache);
+	std::map<int, Matrix > new_coeffs;
+	if (apply) {
+		typedef std::map<int, Matrix>::iterator it_type;
+		for (it_type it = rh_coeffs.begin(); it != rh_coeffs.end(); ++it){
+			new_coeffs[it->first] = apply_func_coeff(lin, i, it->second);
+		}
+	} else {
+		mul_by_const(coeff_mat[i], rh_coeffs, new_coeffs);
+	}
+	return new_coeffs;
+}
+
+/* Sums the maps in PARTS into COEFFS. The matrices of each variable are
+	 added in the order of PARTS, exactly as the serial loop does, and the
+	 variables are summed in parallel. */
+void merge_coefficients(std::vector<std::map<int, Matrix> > &parts,
+                        std::map<int, Matrix> &coeffs){
+	std::map<int, std::vector<Matrix*> > terms;
+	typedef std::map<int, Matrix>::iterator it_type;
+	for (unsigned p = 0; p < parts.size(); p++) {
+		for (it_type it = parts[p].begin(); it != parts[p].end(); ++it){
+			terms[it->first].push_back(&it->second);
+		}
+	}
+	/* Insert every key first, so the tasks only write existing entries */
+	std::vector<std::pair<Matrix*, std::vector<Matrix*>*> > sums;
+	typedef std::map<int, std::vector<Matrix*> >::iterator terms_it;
+	for (terms_it it = terms.begin(); it != terms.end(); ++it){
+		sums.push_back(std::make_pair(&coeffs[it->first], &it->second));
+	}
+	parallel_tasks(sums.size(), [&sums](long k) {
+		Matrix &sum = *sums[k].first;
+		std::vector<Matrix*> &mats = *sums[k].second;
+		sum = std::move(*mats[0]);
+		for (unsigned t = 1; t < mats.size(); t++) {
+			sum += *mats[t];
+		}
+	});
+}
+
+/* Returns the coefficients of LIN by variable id. If CACHE is not NULL,
+	 shared subtrees are looked up in and added to it. */
+std::map<int, Matrix > get_coefficient(LinOp &lin, CoeffCache *cache){
 	std::map<int, Matrix > coeffs;
+	if (cache != NULL && cache->find(&lin, coeffs)) {
+		return coeffs;
+	}
 	if (lin.type == VARIABLE){
 		std::map<int, Matrix> new_coeffs = get_variable_coeffs(lin);
 		typedef std::map<int, Matrix >::iterator it_type;
@@ -74,31 +265,50 @@ std::map<int, Matrix > get_coefficient(LinOp &lin){
 		}
 	}
 	else {
-		/* Multiply the arguments of the function coefficient in order */
-		std::vector<Matrix> coeff_mat = get_func_coeffs(lin); 
-		for (unsigned i = 0; i < lin.args.size(); i++){
-			Matrix coeff = coeff_mat[i];
-			std::map<int, Matrix > rh_coeffs = get_coefficient(*lin.args[i]);
-			std::map<int,  Matrix > new_coeffs;
-			mul_by_const(coeff, rh_coeffs, new_coeffs);
-
-			typedef std::map<int, Matrix>::iterator it_type;
-			for (it_type it = new_coeffs.begin(); it != new_coeffs.end(); ++it){
-				if(coeffs.count(it->first) == 0)
-					coeffs[it->first] = it->second;
-				else
-					coeffs[it->first] += it->second;		
+		/* Multiply the arguments of the function coefficient in order, or
+		   apply the coefficient to each argument's coefficients directly
+		   without building the coefficient matrix */
+		bool apply = has_func_apply(lin);
+		std::vector<Matrix> coeff_mat;
+		if (!apply) {
+			coeff_mat = get_func_coeffs(lin);
+		}
+		unsigned num_args = lin.args.size();
+		if (cache != NULL && num_args > 1 &&
+		    cache->get_cost(&lin) >= PARALLEL_MIN_WORK) {
+			/* Evaluate the argument subtrees as tasks; small subtrees stay on
+			   the calling thread */
+			std::vector<std::map<int, Matrix> > parts(num_args);
+			parallel_tasks(num_args, [&](long i) {
+				parts[i] = get_arg_contribution(lin, i, apply, coeff_mat, cache);
+			});
+			merge_coefficients(parts, coeffs);
+		} else {
+			for (unsigned i = 0; i < num_args; i++){
+				std::map<int,  Matrix > new_coeffs =
+					get_arg_contribution(lin, i, apply, coeff_mat, cache);
+
+				typedef std::map<int, Matrix>::iterator it_type;
+				for (it_type it = new_coeffs.begin(); it != new_coeffs.end(); ++it){
+					if(coeffs.count(it->first) == 0)
+						coeffs[it->first] = it->second;
+					else
+						coeffs[it->first] += it->second;
+				}
 			}
 		}
 	}
+	if (cache != NULL) {
+		cache->store(&lin, coeffs);
+	}
 	return coeffs;
 }
 
 int get_horiz_offset(int id, std::map<int, int> &offsets,
-                     int &horiz_offset, LinOp &lin){
+                     int &horiz_offset, int var_size){
 	if ( !offsets.count(id) ){
 		offsets[id] = horiz_offset;
-		horiz_offset += lin.size[0] * lin.size[1];
+		horiz_offset += var_size;
 	}
 	return offsets[id];
 }
@@ -109,13 +319,30 @@ int get_horiz_offset(int id, std::map<int, int> &offsets,
 * representation, by using eigen's sparse matrix iterator
 * This function takes horizontal and vertical offset, which indicate
 * the offset of this block within our larger matrix.
+*
+* Values are rounded to SCALAR only here, after all coefficient arithmetic
+* has been done in double precision.
+*
+* If STATS is not NULL, the row and column statistics are accumulated
+* while the entries are emitted, which saves solvers a pass over the matrix.
 */
-void add_matrix_to_vectors(Matrix &block, std::vector<double> &V,
-                           std::vector<int>  &I, std::vector<int> &J,
-                           int &vert_offset, int &horiz_offset){
+template <typename Scalar>
+void add_matrix_to_vectors(Matrix &block, Buffer<Scalar> &V,
+                           Buffer<int> &I, Buffer<int> &J,
+                           int &vert_offset, int &horiz_offset,
+                           MatrixStats *stats){
+	if (stats != NULL) {
+		stats->reserve_cols(horiz_offset + block.cols());
+		for ( int k = 0; k < block.outerSize(); ++k ) {
+			for ( Matrix::InnerIterator it(block, k); it; ++it ){
+				stats->add_entry(it.row() + vert_offset, it.col() + horiz_offset,
+				                 it.value());
+			}
+		}
+	}
 	for ( int k = 0; k < block.outerSize(); ++k ) {
 		for ( Matrix::InnerIterator it(block, k); it; ++it ){
-			V.push_back(it.value());
+			V.push_back(static_cast<Scalar>(it.value()));
 
 			/* Push back current row and column indices */
 			I.push_back(it.row() + vert_offset);   	
@@ -124,34 +351,91 @@ void add_matrix_to_vectors(Matrix &block, std::vector<double> &V,
 	}
 }
 
-void extend_constant_vec(std::vector<double> &const_vec, int &vert_offset,
+/* Adds the constant BLOCK of a constraint to CONST_VEC. Each constraint
+   writes a disjoint range of rows, so no cancellation happens in SCALAR. */
+template <typename Scalar>
+void extend_constant_vec(std::vector<Scalar> &const_vec, int &vert_offset,
+                         Matrix &block){
+	int rows = block.rows();
+	for ( int k = 0; k < block.outerSize(); ++k ){
+		for ( Matrix::InnerIterator it(block, k); it; ++it ){
+			int idx = vert_offset + (it.col() * rows) + it.row();
+			const_vec[idx] += static_cast<Scalar>(it.value());
+		}
+	}
+}
+
+/* Nonzero entries of a sparse constant vector, as (row, value) pairs in the
+   order the constraints are processed */
+typedef std::vector<std::pair<int, double> > ConstEntries;
+
+/* Appends the constant BLOCK of a constraint to the sparse CONST_ENTRIES */
+void extend_constant_vec(ConstEntries &const_entries, int &vert_offset,
                          Matrix &block){
 	int rows = block.rows();
 	for ( int k = 0; k < block.outerSize(); ++k ){
 		for ( Matrix::InnerIterator it(block, k); it; ++it ){
 			int idx = vert_offset + (it.col() * rows) + it.row();
-			const_vec[idx] += it.value();
+			const_entries.push_back(std::make_pair(idx, it.value()));
 		}
 	}
 }
 
-void process_constraint(LinOp & lin, std::vector<double> &V,
-                        std::vector<int> &I, std::vector<int> &J,
-                        std::vector<double> &constant_vec, int &vert_offset,
-                        std::map<int, int> &id_to_col, int & horiz_offset){
+/* Sorts and merges CONST_ENTRIES into the sparse constant vector of
+   PROB_DATA, which has NUM_ROWS rows. Entries that sum to zero are
+   dropped. */
+template <typename Scalar>
+void set_sparse_const_vec(ProblemDataT<Scalar> &prob_data,
+                          ConstEntries &const_entries, int num_rows){
+	std::sort(const_entries.begin(), const_entries.end());
+	prob_data.sparse_const = true;
+	prob_data.const_len = num_rows;
+	prob_data.const_vec.clear();
+	prob_data.const_idx.clear();
+	prob_data.const_val.clear();
+	unsigned k = 0;
+	while (k < const_entries.size()) {
+		int idx = const_entries[k].first;
+		double value = 0;
+		for (; k < const_entries.size() && const_entries[k].first == idx; k++) {
+			value += const_entries[k].second;
+		}
+		if (value != 0) {
+			prob_data.const_idx.push_back(idx);
+			prob_data.const_val.push_back(static_cast<Scalar>(value));
+		}
+	}
+	ConstEntries().swap(const_entries);
+}
+
+/* Adds the coefficients of the constraint LIN to the matrix triplets and to
+   CONSTANT_VEC, or to CONST_ENTRIES if it is not NULL */
+template <typename Scalar>
+void process_constraint(LinOp & lin, Buffer<Scalar> &V,
+                        Buffer<int> &I, Buffer<int> &J,
+                        std::vector<Scalar> &constant_vec,
+                        ConstEntries *const_entries, int &vert_offset,
+                        std::map<int, int> &id_to_col, int & horiz_offset,
+                        MatrixStats *stats, CoeffCache *cache){
 	/* Get the coefficient for the current constraint */
-	std::map<int, Matrix > coeffs = get_coefficient(lin);	
+	std::map<int, Matrix > coeffs = get_coefficient(lin, cache);
 
+	/* Each block is released as soon as its entries are emitted */
 	typedef std::map<int, Matrix >::iterator it_type;
-	for(it_type it = coeffs.begin(); it != coeffs.end(); ++it){
+	for(it_type it = coeffs.begin(); it != coeffs.end(); coeffs.erase(it++)){
 		int id = it->first;									// Horiz offset determined by the id
-		Matrix block = it->second;
+		Matrix &block = it->second;
 		if (id == CONSTANT_ID) { // Add to CONSTANT_VEC if linop is constant
-			extend_constant_vec(constant_vec, vert_offset, block);	
+			if (const_entries != NULL) {
+				extend_constant_vec(*const_entries, vert_offset, block);
+			} else {
+				extend_constant_vec(constant_vec, vert_offset, block);
+			}
 		}
 		else {
-			int offset = get_horiz_offset(id, id_to_col, horiz_offset, lin);
-			add_matrix_to_vectors(block, V, I, J, vert_offset, offset);
+			/* The block has one column per entry of the variable */
+			int offset = get_horiz_offset(id, id_to_col, horiz_offset, block.cols());
+			add_matrix_to_vectors(block, V, I, J, vert_offset, offset, stats);
 		}
 	}
 }
@@ -180,7 +464,7 @@ int get_total_constraint_length(std::vector<LinOp*> &constraints,
 	int offset_end = 0;
 	/* Offsets must be monotonically increasing */
 	for(unsigned i = 0; i < constr_offsets.size(); i++){
-		LinOp constr = *constraints[i];
+		LinOp &constr = *constraints[i];
 		int offset_start = constr_offsets[i];
 		offset_end = offset_start + constr.size[0] * constr.size[1];
 
@@ -206,25 +490,50 @@ int get_total_constraint_length(std::vector<LinOp*> &constraints,
 * and maps containing our mapping from variables, and a map from the rows of our
 * matrix to their corresponding constraint.
 *
+* If SPILL is not NULL, the entries are moved to its file whenever they exceed
+* its budget, and the caller puts them back with TripletSpill::unspill.
+*
 */
-ProblemData build_matrix(std::vector< LinOp* > constraints,
-                         std::map<int, int> id_to_col) {
-	ProblemData prob_data;
+template <typename Scalar>
+ProblemDataT<Scalar> build_matrix_t(std::vector< LinOp* > &constraints,
+                                    std::map<int, int> &id_to_col,
+                                    bool compute_stats, CoeffCache *cache,
+                                    int &horiz_offset, bool sparse_const,
+                                    TripletSpill *spill) {
+	ProblemDataT<Scalar> prob_data;
 	int num_rows = get_total_constraint_length(constraints);
-	prob_data.const_vec = std::vector<double> (num_rows, 0);
+	ConstEntries const_entries;
+	ConstEntries *sparse_entries = sparse_const ? &const_entries : NULL;
+	if (!sparse_const) {
+		prob_data.const_vec = std::vector<Scalar> (num_rows, 0);
+	}
 	prob_data.id_to_col = id_to_col;
+	MatrixStats *stats = NULL;
+	if (compute_stats) {
+		stats = &prob_data.stats;
+		stats->reset(num_rows);
+	}
 	int vert_offset = 0;
-	int horiz_offset  = 0;
+	horiz_offset = 0;
 
 	/* Build matrix one constraint at a time */
 	for (unsigned i = 0; i < constraints.size(); i++){
-		LinOp constr = *constraints[i];
+		LinOp &constr = *constraints[i];
 		process_constraint(constr, prob_data.V, prob_data.I, prob_data.J,
-		                   prob_data.const_vec, vert_offset,
-		                   prob_data.id_to_col, horiz_offset);
+		                   prob_data.const_vec, sparse_entries, vert_offset,
+		                   prob_data.id_to_col, horiz_offset, stats, cache);
+		if (spill != NULL) {
+			spill->spill_if_over_budget(prob_data.V, prob_data.I, prob_data.J);
+		}
 		prob_data.const_to_row[i] = vert_offset;
 		vert_offset += constr.size[0] * constr.size[1];
 	}
+	if (stats != NULL) {
+		stats->finalize();
+	}
+	if (sparse_const) {
+		set_sparse_const_vec(prob_data, const_entries, num_rows);
+	}
 	return prob_data;
 }
 
@@ -236,25 +545,538 @@ ProblemData build_matrix(std::vector< LinOp* > constraints,
 		the vertical offset for constraint i + the size of constraint i must be
 		less than the vertical offset for constraint i+1.
 		*/
-ProblemData build_matrix(std::vector<LinOp*> constraints,
-                         std::map<int, int> id_to_col,
-                         std::vector<int> constr_offsets){
-	ProblemData prob_data;
+template <typename Scalar>
+ProblemDataT<Scalar> build_matrix_t(std::vector<LinOp*> &constraints,
+                                    std::map<int, int> &id_to_col,
+                                    std::vector<int> &constr_offsets,
+                                    bool compute_stats, CoeffCache *cache,
+                                    int &horiz_offset, bool sparse_const,
+                                    TripletSpill *spill){
+	ProblemDataT<Scalar> prob_data;
 
 	/* Function also verifies the offsets are valid */
 	int num_rows = get_total_constraint_length(constraints, constr_offsets);
-	prob_data.const_vec = std::vector<double> (num_rows, 0);
+	ConstEntries const_entries;
+	ConstEntries *sparse_entries = sparse_const ? &const_entries : NULL;
+	if (!sparse_const) {
+		prob_data.const_vec = std::vector<Scalar> (num_rows, 0);
+	}
 	prob_data.id_to_col = id_to_col;
-	int horiz_offset  = 0;
+	MatrixStats *stats = NULL;
+	if (compute_stats) {
+		stats = &prob_data.stats;
+		stats->reset(num_rows);
+	}
+	horiz_offset = 0;
 
 	/* Build matrix one constraint at a time */
 	for (unsigned i = 0; i < constraints.size(); i++){
-		LinOp constr = *constraints[i];
+		LinOp &constr = *constraints[i];
 		int vert_offset = constr_offsets[i];
 		process_constraint(constr, prob_data.V, prob_data.I, prob_data.J,
-		                   prob_data.const_vec, vert_offset,
-		                   prob_data.id_to_col, horiz_offset);
+		                   prob_data.const_vec, sparse_entries, vert_offset,
+		                   prob_data.id_to_col, horiz_offset, stats, cache);
+		if (spill != NULL) {
+			spill->spill_if_over_budget(prob_data.V, prob_data.I, prob_data.J);
+		}
 		prob_data.const_to_row[i] = vert_offset;
 	}
+	if (stats != NULL) {
+		stats->finalize();
+	}
+	if (sparse_const) {
+		set_sparse_const_vec(prob_data, const_entries, num_rows);
+	}
 	return prob_data;
-}
\ No newline at end of file
+}
+
+/*  Adds the objective OBJECTIVE, a scalar LinOp c^T x + d, to PROB_DATA. Its
+		variables share the columns of the constraints, and variables that only
+		appear in the objective are given new columns. OBJ_VEC gets one entry
+		per column of the matrix. */
+template <typename Scalar>
+void process_objective(LinOp &objective, ProblemDataT<Scalar> &prob_data,
+                       int &horiz_offset, CoeffCache *cache) {
+	if (objective.size[0] * objective.size[1] != 1) {
+		std::cerr << "Error: the objective must be a scalar LinOp." << std::endl;
+		exit(-1);
+	}
+	std::map<int, Matrix > coeffs = get_coefficient(objective, cache);
+
+	int num_cols = horiz_offset;
+	for (unsigned k = 0; k < prob_data.J.size(); k++) {
+		num_cols = std::max(num_cols, prob_data.J[k] + 1);
+	}
+	std::vector<std::pair<int, double> > entries;
+	double offset = 0;
+	typedef std::map<int, Matrix >::iterator it_type;
+	for (it_type it = coeffs.begin(); it != coeffs.end(); ++it) {
+		Matrix &block = it->second;
+		if (it->first == CONSTANT_ID) {
+			for (int k = 0; k < block.outerSize(); ++k) {
+				for (Matrix::InnerIterator e(block, k); e; ++e) {
+					offset += e.value();
+				}
+			}
+			continue;
+		}
+		int col = get_horiz_offset(it->first, prob_data.id_to_col, horiz_offset,
+		                           block.cols());
+		num_cols = std::max(num_cols, col + (int) block.cols());
+		for (int k = 0; k < block.outerSize(); ++k) {
+			for (Matrix::InnerIterator e(block, k); e; ++e) {
+				entries.push_back(std::make_pair(col + e.col(), e.value()));
+			}
+		}
+	}
+
+	/* Sum in double precision, then round */
+	std::vector<double> obj_vec(num_cols, 0);
+	for (unsigned k = 0; k < entries.size(); k++) {
+		obj_vec[entries[k].first] += entries[k].second;
+	}
+	prob_data.obj_vec.assign(obj_vec.begin(), obj_vec.end());
+	prob_data.obj_offset = static_cast<Scalar>(offset);
+}
+
+/*  Runs build_matrix followed by the optional stages selected in OPTIONS.
+		If CONSTR_OFFSETS is empty, the constraints are stacked vertically in
+		order. If OBJECTIVE is not NULL, its coefficients are computed in the
+		same pass and returned in OBJ_VEC and OBJ_OFFSET. The parallel loops
+		and the output buffers use CONTEXT, if it is not NULL.
+
+		With a MEMORY_BUDGET in OPTIONS, the finished constraints are spilled
+		to disk during the build. If any were, the matrix is returned in
+		memory mapped files, and the later stages take their temporary arrays
+		from such files too. */
+template <typename Scalar>
+ProblemDataT<Scalar> build_matrix_t(std::vector<LinOp*> &constraints,
+                                    LinOp *objective,
+                                    std::map<int, int> &id_to_col,
+                                    std::vector<int> &constr_offsets,
+                                    BuildOptions &options,
+                                    ExecutionContext *context){
+	ContextScope scope(context);
+
+	/* Summing duplicates changes the norms, so with CANONICALIZE the
+	   statistics are computed afterwards instead of during the build */
+	bool stats_during_build = options.compute_stats && !options.canonicalize;
+
+	/* Subtrees shared by the constraints and the objective are computed once */
+	std::vector<LinOp*> roots = constraints;
+	roots.push_back(objective);
+	CoeffCache cache(roots);
+
+	std::unique_ptr<TripletSpill> spill;
+	if (options.memory_budget > 0) {
+		spill.reset(new TripletSpill(options.spill_dir, options.memory_budget));
+	}
+
+	ProblemDataT<Scalar> prob_data;
+	int horiz_offset;
+	if (constr_offsets.empty()) {
+		prob_data = build_matrix_t<Scalar>(constraints, id_to_col,
+		                                   stats_during_build, &cache,
+		                                   horiz_offset, options.sparse_const_vec,
+		                                   spill.get());
+	} else {
+		prob_data = build_matrix_t<Scalar>(constraints, id_to_col, constr_offsets,
+		                                   stats_during_build, &cache,
+		                                   horiz_offset, options.sparse_const_vec,
+		                                   spill.get());
+	}
+	std::shared_ptr<MemoryResource> file_resource;
+	if (spill && spill->unspill(prob_data.V, prob_data.I, prob_data.J)) {
+		file_resource.reset(new FileResource(spill->get_dir(),
+		                                     PAGE_RESOURCE_MIN_BYTES));
+	}
+	ResourceScope resource_scope(file_resource);
+	if (objective != NULL) {
+		process_objective(*objective, prob_data, horiz_offset, &cache);
+	}
+	if (options.canonicalize) {
+		canonicalize(prob_data, options.zero_tol);
+		if (options.compute_stats) {
+			compute_stats(prob_data);
+		}
+	}
+	if (options.equilibrate) {
+		equilibrate(prob_data);
+	}
+	return prob_data;
+}
+
+/*  Applies the optional stages of OPTIONS that make sense per block to one
+		block of a cone partitioned problem. */
+template <typename Scalar>
+void finish_cone_block(ProblemDataT<Scalar> &block, BuildOptions &options) {
+	if (options.canonicalize) {
+		canonicalize(block, options.zero_tol);
+		if (options.compute_stats) {
+			compute_stats(block);
+		}
+	} else if (options.compute_stats) {
+		/* Accumulated during the build */
+		block.stats.finalize();
+	}
+}
+
+/*  Builds the equality and inequality blocks of a cone program in one pass
+		over CONSTRAINTS. Each constraint is written straight to its place in
+		its block, so no rows are moved afterwards. */
+template <typename Scalar>
+ConeProblemDataT<Scalar> build_cone_matrix_t(std::vector<LinOp*> &constraints,
+                                             std::vector<int> &cone_types,
+                                             std::map<int, int> &id_to_col,
+                                             BuildOptions &options,
+                                             ExecutionContext *context) {
+	ContextScope scope(context);
+	if (constraints.size() != cone_types.size()) {
+		throw std::invalid_argument("CONE_TYPES must be the same length as "
+		                            "CONSTRAINTS");
+	}
+	if (options.equilibrate) {
+		throw std::invalid_argument("equilibrate is not supported for cone "
+		                            "partitioned problems, since both blocks "
+		                            "must share column scaling");
+	}
+
+	ConeProblemDataT<Scalar> result;
+	result.cone_rows.assign(NUM_CONE_TYPES, 0);
+	result.cone_sizes.resize(NUM_CONE_TYPES);
+	for (unsigned i = 0; i < constraints.size(); i++) {
+		if (cone_types[i] < 0 || cone_types[i] >= NUM_CONE_TYPES) {
+			throw std::invalid_argument("invalid cone type " +
+			                            std::to_string(cone_types[i]));
+		}
+		int rows = constraints[i]->size[0] * constraints[i]->size[1];
+		result.cone_rows[cone_types[i]] += rows;
+		result.cone_sizes[cone_types[i]].push_back(rows);
+	}
+
+	/* Start of each cone within its block. The zero cone is the whole
+	   equality block, and the other cones follow each other in G. */
+	std::vector<int> next_row(NUM_CONE_TYPES, 0);
+	for (int cone = CONE_NONNEG + 1; cone < NUM_CONE_TYPES; cone++) {
+		next_row[cone] = next_row[cone - 1] + result.cone_rows[cone - 1];
+	}
+	int num_ineq_rows = next_row[NUM_CONE_TYPES - 1] +
+	                    result.cone_rows[NUM_CONE_TYPES - 1];
+
+	int num_eq_rows = result.cone_rows[CONE_ZERO];
+	ConstEntries eq_entries;
+	ConstEntries ineq_entries;
+	if (!options.sparse_const_vec) {
+		result.eq.const_vec = std::vector<Scalar>(num_eq_rows, 0);
+		result.ineq.const_vec = std::vector<Scalar>(num_ineq_rows, 0);
+	}
+
+	bool stats_during_build = options.compute_stats && !options.canonicalize;
+	MatrixStats *eq_stats = NULL;
+	MatrixStats *ineq_stats = NULL;
+	if (stats_during_build) {
+		eq_stats = &result.eq.stats;
+		ineq_stats = &result.ineq.stats;
+		eq_stats->reset(num_eq_rows);
+		ineq_stats->reset(num_ineq_rows);
+	}
+
+	/* Each block gets half of the memory budget */
+	std::unique_ptr<TripletSpill> eq_spill;
+	std::unique_ptr<TripletSpill> ineq_spill;
+	if (options.memory_budget > 0) {
+		eq_spill.reset(new TripletSpill(options.spill_dir,
+		                                options.memory_budget / 2));
+		ineq_spill.reset(new TripletSpill(options.spill_dir,
+		                                  options.memory_budget / 2));
+	}
+
+	/* Columns are assigned across both blocks */
+	CoeffCache cache(constraints);
+	std::map<int, int> cols = id_to_col;
+	int horiz_offset = 0;
+	for (unsigned i = 0; i < constraints.size(); i++) {
+		LinOp &constr = *constraints[i];
+		int cone = cone_types[i];
+		ProblemDataT<Scalar> &block = cone == CONE_ZERO ? result.eq : result.ineq;
+		ConstEntries *entries = NULL;
+		if (options.sparse_const_vec) {
+			entries = cone == CONE_ZERO ? &eq_entries : &ineq_entries;
+		}
+		int vert_offset = next_row[cone];
+		process_constraint(constr, block.V, block.I, block.J, block.const_vec,
+		                   entries, vert_offset, cols, horiz_offset,
+		                   cone == CONE_ZERO ? eq_stats : ineq_stats, &cache);
+		TripletSpill *spill = cone == CONE_ZERO ? eq_spill.get() : ineq_spill.get();
+		if (spill != NULL) {
+			spill->spill_if_over_budget(block.V, block.I, block.J);
+		}
+		block.const_to_row[i] = vert_offset;
+		next_row[cone] += constr.size[0] * constr.size[1];
+	}
+	result.eq.id_to_col = cols;
+	result.ineq.id_to_col = cols;
+	if (options.sparse_const_vec) {
+		set_sparse_const_vec(result.eq, eq_entries, num_eq_rows);
+		set_sparse_const_vec(result.ineq, ineq_entries, num_ineq_rows);
+	}
+
+	std::shared_ptr<MemoryResource> file_resource;
+	if (options.memory_budget > 0) {
+		bool eq_mapped = eq_spill->unspill(result.eq.V, result.eq.I, result.eq.J);
+		bool ineq_mapped = ineq_spill->unspill(result.ineq.V, result.ineq.I,
+		                                       result.ineq.J);
+		if (eq_mapped || ineq_mapped) {
+			file_resource.reset(new FileResource(eq_spill->get_dir(),
+			                                     PAGE_RESOURCE_MIN_BYTES));
+		}
+	}
+	ResourceScope resource_scope(file_resource);
+	finish_cone_block(result.eq, options);
+	finish_cone_block(result.ineq, options);
+	return result;
+}
+
+/* Writes the argument of the QUAD_FORM term with coefficients COEFFS as
+	 B x + C, where B has one column per column of the problem and C is
+	 dense. */
+void get_quad_arg(std::map<int, Matrix> &coeffs, std::map<int, int> &id_to_col,
+                  int n, int num_cols, Matrix &B, Eigen::VectorXd &c) {
+	std::vector<Triplet> tripletList;
+	c = Eigen::VectorXd::Zero(n);
+	typedef std::map<int, Matrix >::iterator it_type;
+	for (it_type it = coeffs.begin(); it != coeffs.end(); ++it) {
+		Matrix &block = it->second;
+		if (it->first == CONSTANT_ID) {
+			for (int k = 0; k < block.outerSize(); ++k) {
+				for (Matrix::InnerIterator e(block, k); e; ++e) {
+					c(e.col() * block.rows() + e.row()) += e.value();
+				}
+			}
+		} else {
+			int offset = id_to_col[it->first];
+			for (int k = 0; k < block.outerSize(); ++k) {
+				for (Matrix::InnerIterator e(block, k); e; ++e) {
+					tripletList.push_back(Triplet(e.row(), offset + e.col(),
+					                              e.value()));
+				}
+			}
+		}
+	}
+	B = Matrix(n, num_cols);
+	B.setFromTriplets(tripletList.begin(), tripletList.end());
+	B.makeCompressed();
+}
+
+/* function: build_quad_matrix
+*
+* Builds the quadratic objective (1/2) x^T P x + q^T x + r equal to the
+* sum of the QUAD_FORM linOps in QUAD_TERMS. The argument of each term is
+* written as B x + c with GET_COEFFICIENT, exactly like a constraint, and
+* the term x^T Q x contributes
+*
+* 		P += 2 B^T Q B,  q += 2 B^T Q c,  r += c^T Q c
+*
+* using sparse products. Columns are assigned as in build_matrix, and P has
+* at least NUM_COLS columns so it lines up with the constraint matrix.
+*/
+QuadProblemData build_quad_matrix(std::vector<LinOp*> quad_terms,
+                                  std::map<int, int> id_to_col,
+                                  int num_cols) {
+	QuadProblemData quad_data;
+	quad_data.id_to_col = id_to_col;
+	int horiz_offset = 0;
+
+	/* Columns must be known before P is sized, so all coefficients are
+		 computed first */
+	std::vector<std::map<int, Matrix> > arg_coeffs(quad_terms.size());
+	CoeffCache cache(quad_terms);
+	for (unsigned i = 0; i < quad_terms.size(); i++) {
+		LinOp &term = *quad_terms[i];
+		if (term.type != QUAD_FORM) {
+			std::cerr << "Error: quadratic terms must be QUAD_FORM linOps."
+			          << std::endl;
+			exit(-1);
+		}
+		arg_coeffs[i] = get_coefficient(*term.args[0], &cache);
+		typedef std::map<int, Matrix >::iterator it_type;
+		for (it_type it = arg_coeffs[i].begin(); it != arg_coeffs[i].end(); ++it) {
+			if (it->first != CONSTANT_ID) {
+				int cols = it->second.cols();
+				int offset = get_horiz_offset(it->first, quad_data.id_to_col,
+				                              horiz_offset, cols);
+				num_cols = std::max(num_cols, offset + cols);
+			}
+		}
+	}
+	num_cols = std::max(num_cols, 0);
+
+	Matrix P(num_cols, num_cols);
+	Eigen::VectorXd q = Eigen::VectorXd::Zero(num_cols);
+	for (unsigned i = 0; i < quad_terms.size(); i++) {
+		LinOp &term = *quad_terms[i];
+		Matrix Q = get_quad_form_mat(term);
+		Matrix B;
+		Eigen::VectorXd c;
+		get_quad_arg(arg_coeffs[i], quad_data.id_to_col, Q.rows(), num_cols,
+		             B, c);
+		arg_coeffs[i].clear();
+
+		Matrix QB = Q * B;
+		Matrix Bt = B.transpose();
+		P += 2 * (Bt * QB);
+		Eigen::VectorXd Qc = Q * c;
+		q += 2 * (Bt * Qc);
+		quad_data.r += c.dot(Qc);
+	}
+	P.makeCompressed();
+
+	/* Keep the upper triangle, column by column */
+	quad_data.num_cols = num_cols;
+	quad_data.P_indptr.resize(num_cols + 1);
+	quad_data.P_indptr[0] = 0;
+	for (int j = 0; j < num_cols; j++) {
+		for (Matrix::InnerIterator it(P, j); it; ++it) {
+			if (it.row() > j) {
+				break;
+			}
+			quad_data.P_indices.push_back(it.row());
+			quad_data.P_data.push_back(it.value());
+		}
+		quad_data.P_indptr[j + 1] = quad_data.P_data.size();
+	}
+	quad_data.q.assign(q.data(), q.data() + num_cols);
+	return quad_data;
+}
+
+ProblemData build_matrix(std::vector< LinOp* > constraints,
+                         std::map<int, int> id_to_col) {
+	CoeffCache cache(constraints);
+	int horiz_offset;
+	return build_matrix_t<double>(constraints, id_to_col, false, &cache,
+	                              horiz_offset, false, NULL);
+}
+
+ProblemData build_matrix(std::vector<LinOp*> constraints,
+                         std::map<int, int> id_to_col,
+                         std::vector<int> constr_offsets){
+	CoeffCache cache(constraints);
+	int horiz_offset;
+	return build_matrix_t<double>(constraints, id_to_col, constr_offsets, false,
+	                              &cache, horiz_offset, false, NULL);
+}
+
+/*  Single precision variants of build_matrix. The coefficients are computed
+		in double precision exactly as above, and V and CONST_VEC are rounded to
+		float as they are written, which halves the memory traffic of the
+		output. */
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints,
+                                    std::map<int, int> id_to_col) {
+	CoeffCache cache(constraints);
+	int horiz_offset;
+	return build_matrix_t<float>(constraints, id_to_col, false, &cache,
+	                             horiz_offset, false, NULL);
+}
+
+ProblemDataFloat build_matrix_float(std::vector<LinOp*> constraints,
+                                    std::map<int, int> id_to_col,
+                                    std::vector<int> constr_offsets){
+	CoeffCache cache(constraints);
+	int horiz_offset;
+	return build_matrix_t<float>(constraints, id_to_col, constr_offsets, false,
+	                             &cache, horiz_offset, false, NULL);
+}
+
+ProblemData build_matrix(std::vector<LinOp*> constraints,
+                         std::map<int, int> id_to_col,
+                         std::vector<int> constr_offsets,
+                         BuildOptions options){
+	return build_matrix_t<double>(constraints, NULL, id_to_col, constr_offsets,
+	                              options, NULL);
+}
+
+ProblemDataFloat build_matrix_float(std::vector<LinOp*> constraints,
+                                    std::map<int, int> id_to_col,
+                                    std::vector<int> constr_offsets,
+                                    BuildOptions options){
+	return build_matrix_t<float>(constraints, NULL, id_to_col, constr_offsets,
+	                             options, NULL);
+}
+
+/*  Variants of build_matrix which also return the objective OBJECTIVE, a
+		scalar LinOp, as the dense vector OBJ_VEC and offset OBJ_OFFSET. The
+		objective shares the columns and the memoized subtrees of the
+		constraints. */
+ProblemData build_matrix(std::vector<LinOp*> constraints,
+                         LinOp *objective,
+                         std::map<int, int> id_to_col,
+                         std::vector<int> constr_offsets,
+                         BuildOptions options){
+	return build_matrix_t<double>(constraints, objective, id_to_col,
+	                              constr_offsets, options, NULL);
+}
+
+ProblemDataFloat build_matrix_float(std::vector<LinOp*> constraints,
+                                    LinOp *objective,
+                                    std::map<int, int> id_to_col,
+                                    std::vector<int> constr_offsets,
+                                    BuildOptions options){
+	return build_matrix_t<float>(constraints, objective, id_to_col,
+	                             constr_offsets, options, NULL);
+}
+
+/*  Variants of build_matrix which run in the ExecutionContext CONTEXT, see
+		ExecutionContext.hpp. OBJECTIVE may be NULL. */
+ProblemData build_matrix(std::vector<LinOp*> constraints,
+                         LinOp *objective,
+                         std::map<int, int> id_to_col,
+                         std::vector<int> constr_offsets,
+                         BuildOptions options,
+                         ExecutionContext *context){
+	return build_matrix_t<double>(constraints, objective, id_to_col,
+	                              constr_offsets, options, context);
+}
+
+ProblemDataFloat build_matrix_float(std::vector<LinOp*> constraints,
+                                    LinOp *objective,
+                                    std::map<int, int> id_to_col,
+                                    std::vector<int> constr_offsets,
+                                    BuildOptions options,
+                                    ExecutionContext *context){
+	return build_matrix_t<float>(constraints, objective, id_to_col,
+	                             constr_offsets, options, context);
+}
+
+ConeProblemData build_cone_matrix(std::vector<LinOp*> constraints,
+                                  std::vector<int> cone_types,
+                                  std::map<int, int> id_to_col,
+                                  BuildOptions options) {
+	return build_cone_matrix_t<double>(constraints, cone_types, id_to_col,
+	                                   options, NULL);
+}
+
+ConeProblemDataFloat build_cone_matrix_float(std::vector<LinOp*> constraints,
+                                             std::vector<int> cone_types,
+                                             std::map<int, int> id_to_col,
+                                             BuildOptions options) {
+	return build_cone_matrix_t<float>(constraints, cone_types, id_to_col,
+	                                  options, NULL);
+}
+
+ConeProblemData build_cone_matrix(std::vector<LinOp*> constraints,
+                                  std::vector<int> cone_types,
+                                  std::map<int, int> id_to_col,
+                                  BuildOptions options,
+                                  ExecutionContext *context) {
+	return build_cone_matrix_t<double>(constraints, cone_types, id_to_col,
+	                                   options, context);
+}
+
+ConeProblemDataFloat build_cone_matrix_float(std::vector<LinOp*> constraints,
+                                             std::vector<int> cone_types,
+                                             std::map<int, int> id_to_col,
+                                             BuildOptions options,
+                                             ExecutionContext *context) {
+	return build_cone_matrix_t<float>(constraints, cone_types, id_to_col,
+	                                  options, context);
+}
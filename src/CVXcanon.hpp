@@ -20,8 +20,32 @@
 #include "LinOp.hpp"
 #include "Utils.hpp"
 #include "ProblemData.hpp"
+#include "BuildOptions.hpp"
+#include "ExecutionContext.hpp"
 
 // Top Level Entry point
 ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col);
 ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets);
-#endif
\ No newline at end of file
+
+// With optional stages, see BuildOptions.hpp. Empty constr_offsets stack the constraints in order.
+ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+
+// Single precision output (V and const_vec stored as float)
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemData build_matrix(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+
+// Run in an ExecutionContext (thread pool, CPU placement, memory resource), see ExecutionContext.hpp. objective may be NULL.
+ProblemData build_matrix(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options, ExecutionContext *context);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options, ExecutionContext *context);
+
+// Partitioned by cone, see ConeProblemDataT in ProblemData.hpp. cone_types holds a ConeType for each constraint. Throws std::invalid_argument for an unknown cone type or with options.equilibrate.
+ConeProblemData build_cone_matrix(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options);
+ConeProblemDataFloat build_cone_matrix_float(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options);
+ConeProblemData build_cone_matrix(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options, ExecutionContext *context);
+ConeProblemDataFloat build_cone_matrix_float(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options, ExecutionContext *context);
+
+QuadProblemData build_quad_matrix(std::vector< LinOp* > quad_terms, std::map<int, int> id_to_col, int num_cols);
+#endif
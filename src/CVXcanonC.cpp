@@ -0,0 +1,694 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "CVXcanonC.h"
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+/* The C node types are fixed, so a change to OperatorType must not move
+   them */
+static_assert(int(CVXCANON_OP_VARIABLE) == VARIABLE &&
+              int(CVXCANON_OP_PROMOTE) == PROMOTE &&
+              int(CVXCANON_OP_MUL) == MUL &&
+              int(CVXCANON_OP_RMUL) == RMUL &&
+              int(CVXCANON_OP_MUL_ELEM) == MUL_ELEM &&
+              int(CVXCANON_OP_DIV) == DIV &&
+              int(CVXCANON_OP_SUM) == SUM &&
+              int(CVXCANON_OP_NEG) == NEG &&
+              int(CVXCANON_OP_INDEX) == INDEX &&
+              int(CVXCANON_OP_TRANSPOSE) == TRANSPOSE &&
+              int(CVXCANON_OP_SUM_ENTRIES) == SUM_ENTRIES &&
+              int(CVXCANON_OP_TRACE) == TRACE &&
+              int(CVXCANON_OP_RESHAPE) == RESHAPE &&
+              int(CVXCANON_OP_DIAG_VEC) == DIAG_VEC &&
+              int(CVXCANON_OP_DIAG_MAT) == DIAG_MAT &&
+              int(CVXCANON_OP_UPPER_TRI) == UPPER_TRI &&
+              int(CVXCANON_OP_CONV) == CONV &&
+              int(CVXCANON_OP_HSTACK) == HSTACK &&
+              int(CVXCANON_OP_VSTACK) == VSTACK &&
+              int(CVXCANON_OP_SCALAR_CONST) == SCALAR_CONST &&
+              int(CVXCANON_OP_DENSE_CONST) == DENSE_CONST &&
+              int(CVXCANON_OP_SPARSE_CONST) == SPARSE_CONST &&
+              int(CVXCANON_OP_NO_OP) == NO_OP &&
+              int(CVXCANON_OP_KRON) == KRON &&
+              int(CVXCANON_OP_SUM_AXIS) == SUM_AXIS &&
+              int(CVXCANON_OP_CUMSUM) == CUMSUM &&
+              int(CVXCANON_OP_DIFF) == DIFF &&
+              int(CVXCANON_OP_BLOCK_DIAG_MUL) == BLOCK_DIAG_MUL &&
+              int(CVXCANON_OP_SVEC) == SVEC &&
+              int(CVXCANON_OP_KRON_RIGHT) == KRON_RIGHT &&
+              int(CVXCANON_OP_CONV2D) == CONV2D &&
+              int(CVXCANON_OP_QUAD_FORM) == QUAD_FORM,
+              "CVXCANON_OP_* values must match OperatorType");
+
+/* Last valid node type accepted through the C interface */
+static const int LAST_OPERATOR_TYPE = CVXCANON_OP_QUAD_FORM;
+
+/* Holds the result of a build. Exactly one of DATA and DATA_FLOAT is
+   filled, depending on SINGLE. */
+struct cvxcanon_problem {
+	ProblemData data;
+	ProblemDataFloat data_float;
+	bool single;
+	int num_cols;
+};
+
+/**
+ * Checks that the child indices of TREE are in range and that the nodes
+ * reachable from ROOT form a DAG, so that get_coefficient terminates.
+ * STATE is 0 for unvisited nodes, 1 for nodes on the current path and 2
+ * for finished nodes.
+ */
+static bool check_acyclic(const cvxcanon_tree *tree, int root,
+                          std::vector<char> &state) {
+	/* Iterative DFS, (node, next child position) pairs */
+	std::vector<std::pair<int, int> > stack;
+	if (state[root] == 2) {
+		return true;
+	}
+	state[root] = 1;
+	stack.push_back(std::make_pair(root, tree->arg_ptr[root]));
+	while (!stack.empty()) {
+		int node = stack.back().first;
+		int pos = stack.back().second;
+		if (pos == tree->arg_ptr[node + 1]) {
+			state[node] = 2;
+			stack.pop_back();
+			continue;
+		}
+		stack.back().second++;
+		int child = tree->arg_idx[pos];
+		if (child < 0 || child >= tree->num_nodes || state[child] == 1) {
+			return false;
+		}
+		if (state[child] == 0) {
+			state[child] = 1;
+			stack.push_back(std::make_pair(child, tree->arg_ptr[child]));
+		}
+	}
+	return true;
+}
+
+/* Number of entries of node I of TREE */
+static long node_len(const cvxcanon_tree *tree, int i) {
+	return (long) tree->size[2 * i] * tree->size[2 * i + 1];
+}
+
+/* Entry K of the dense data of node I, in column major order */
+static double dense_entry(const cvxcanon_tree *tree, int i, int k) {
+	return tree->data_val[tree->data_ptr[i] + k];
+}
+
+/* Number of entries selected by the slice of INDEX node I from its ROWS x
+   COLS argument, following get_index_mat. Returns -1 for a zero step,
+   which would never end. */
+static long count_slice(const cvxcanon_tree *tree, int i, int rows,
+                        int cols) {
+	const int *sl = tree->slice + 6 * i;
+	if (sl[2] == 0 || sl[5] == 0) {
+		return -1;
+	}
+	long count = 0;
+	for (int col = sl[3]; col >= 0 && col < cols; col += sl[5]) {
+		for (int row = sl[0]; row >= 0 && row < rows; row += sl[2]) {
+			count++;
+			if ((sl[2] > 0 && row + sl[2] >= sl[1]) ||
+			    (sl[2] < 0 && row + sl[2] <= sl[1])) {
+				break;
+			}
+		}
+		if ((sl[5] > 0 && col + sl[5] >= sl[4]) ||
+		    (sl[5] < 0 && col + sl[5] <= sl[4])) {
+			break;
+		}
+	}
+	return count;
+}
+
+/**
+ * Checks that node I of TREE has the number of arguments, the data and the
+ * size its coefficient in LinOpOperations.cpp expects, so that the build
+ * neither exits nor reads out of bounds. The child indices must already
+ * be in range.
+ */
+static bool check_node(const cvxcanon_tree *tree, int i) {
+	int type = tree->type[i];
+	int rows = tree->size[2 * i];
+	int cols = tree->size[2 * i + 1];
+	long len = node_len(tree, i);
+	int num_args = tree->arg_ptr[i + 1] - tree->arg_ptr[i];
+	int data_rows = tree->data_size[2 * i];
+	int data_cols = tree->data_size[2 * i + 1];
+	bool sparse = tree->data_sparse != NULL && tree->data_sparse[i];
+	long data_len = sparse ? 0 : tree->data_ptr[i + 1] - tree->data_ptr[i];
+	if (len > INT_MAX || (long) data_rows * data_cols > INT_MAX) {
+		return false;
+	}
+
+	switch (type) {
+	case CVXCANON_OP_VARIABLE:
+		return num_args == 0 && data_len >= 1;
+	case CVXCANON_OP_SCALAR_CONST:
+	case CVXCANON_OP_DENSE_CONST:
+	case CVXCANON_OP_SPARSE_CONST:
+		return num_args == 0 && (long) data_rows * data_cols == len;
+	case CVXCANON_OP_SUM:
+		if (num_args == 0) {
+			return false;
+		}
+		for (int k = tree->arg_ptr[i]; k < tree->arg_ptr[i + 1]; k++) {
+			if (node_len(tree, tree->arg_idx[k]) != len) {
+				return false;
+			}
+		}
+		return true;
+	case CVXCANON_OP_HSTACK:
+	case CVXCANON_OP_VSTACK: {
+		if (num_args == 0) {
+			return false;
+		}
+		long total = 0;
+		for (int k = tree->arg_ptr[i]; k < tree->arg_ptr[i + 1]; k++) {
+			int arg = tree->arg_idx[k];
+			if (type == CVXCANON_OP_HSTACK) {
+				if (tree->size[2 * arg] != rows) {
+					return false;
+				}
+				total += tree->size[2 * arg + 1];
+			} else {
+				if (tree->size[2 * arg + 1] != cols) {
+					return false;
+				}
+				total += tree->size[2 * arg];
+			}
+		}
+		return total == (type == CVXCANON_OP_HSTACK ? cols : rows);
+	}
+	case CVXCANON_OP_NO_OP:
+	case CVXCANON_OP_QUAD_FORM:
+		return false;
+	default:
+		break;
+	}
+
+	/* The remaining types have a single argument */
+	if (num_args != 1) {
+		return false;
+	}
+	int arg = tree->arg_idx[tree->arg_ptr[i]];
+	int arg_rows = tree->size[2 * arg];
+	int arg_cols = tree->size[2 * arg + 1];
+	long arg_len = node_len(tree, arg);
+	switch (type) {
+	case CVXCANON_OP_PROMOTE:
+		return arg_len == 1;
+	case CVXCANON_OP_MUL:
+		if (data_rows == 1 && data_cols == 1) {
+			return len == arg_len;
+		}
+		return (long) cols * data_cols == arg_len &&
+		       (long) cols * data_rows == len;
+	case CVXCANON_OP_RMUL:
+		return (long) rows * data_rows == arg_len &&
+		       (long) rows * data_cols == len;
+	case CVXCANON_OP_MUL_ELEM:
+		if (len != arg_len) {
+			return false;
+		}
+		return (long) data_rows * data_cols == arg_len ||
+		       ((data_rows == 1 || data_rows == arg_rows) &&
+		        (data_cols == 1 || data_cols == arg_cols));
+	case CVXCANON_OP_DIV:
+		return len == arg_len && data_len >= 1;
+	case CVXCANON_OP_NEG:
+	case CVXCANON_OP_RESHAPE:
+		return len == arg_len;
+	case CVXCANON_OP_INDEX:
+		if (len == 0 || arg_len == 0) {
+			return true;
+		}
+		return count_slice(tree, i, arg_rows, arg_cols) == len;
+	case CVXCANON_OP_TRANSPOSE:
+		return rows == arg_cols && cols == arg_rows;
+	case CVXCANON_OP_SUM_ENTRIES:
+		return len == 1;
+	case CVXCANON_OP_TRACE:
+		return arg_rows == arg_cols && len == 1;
+	case CVXCANON_OP_DIAG_VEC:
+		return rows == cols && arg_len == rows;
+	case CVXCANON_OP_DIAG_MAT:
+		return cols == 1 && arg_rows == rows && arg_cols == rows;
+	case CVXCANON_OP_UPPER_TRI: {
+		long count = 0;
+		for (int r = 0; r < arg_rows; r++) {
+			count += std::max(arg_cols - r - 1, 0);
+		}
+		return cols == 1 && rows == count;
+	}
+	case CVXCANON_OP_CONV:
+		return arg_cols == 1 && cols == 1 && data_cols == 1 &&
+		       data_rows >= 1 && rows == arg_rows + data_rows - 1;
+	case CVXCANON_OP_KRON:
+	case CVXCANON_OP_KRON_RIGHT:
+		return (long) rows == (long) data_rows * arg_rows &&
+		       (long) cols == (long) data_cols * arg_cols;
+	case CVXCANON_OP_CONV2D:
+		return data_rows >= 1 && data_cols >= 1 &&
+		       rows == arg_rows + data_rows - 1 &&
+		       cols == arg_cols + data_cols - 1;
+	case CVXCANON_OP_SUM_AXIS:
+	case CVXCANON_OP_CUMSUM:
+	case CVXCANON_OP_DIFF: {
+		if (data_len < 1) {
+			return false;
+		}
+		double axis = dense_entry(tree, i, 0);
+		if (axis != 0 && axis != 1) {
+			return false;
+		}
+		if (type == CVXCANON_OP_SUM_AXIS) {
+			return len == (axis == 0 ? arg_cols : arg_rows);
+		}
+		if (type == CVXCANON_OP_CUMSUM) {
+			return len == arg_len;
+		}
+		/* The order is entry (0, 1) of the data, 1 if there is none */
+		int order = 1;
+		if (data_len >= 2) {
+			if (data_cols < 2 || dense_entry(tree, i, data_rows) < 0) {
+				return false;
+			}
+			order = int(dense_entry(tree, i, data_rows));
+		}
+		if (axis == 0) {
+			return len == (long) std::max(arg_rows - order, 0) * arg_cols;
+		}
+		return len == (long) arg_rows * std::max(arg_cols - order, 0);
+	}
+	case CVXCANON_OP_BLOCK_DIAG_MUL:
+		if (arg_rows == 0 || data_cols == 0 || data_cols % arg_rows != 0 ||
+		    arg_cols % (data_cols / arg_rows) != 0) {
+			return false;
+		}
+		return len == (long) data_rows * arg_cols;
+	case CVXCANON_OP_SVEC:
+		return arg_rows == arg_cols &&
+		       len == (long) arg_rows * (arg_rows + 1) / 2;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Validates the flat arrays of TREE: the indices and lengths of the arrays,
+ * and, with check_node, that every node fits its arguments and data.
+ */
+static int check_tree(const cvxcanon_tree *tree) {
+	if (tree == NULL || tree->num_nodes < 0 || tree->type == NULL ||
+	    tree->size == NULL || tree->arg_ptr == NULL || tree->data_ptr == NULL ||
+	    tree->data_size == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	int n = tree->num_nodes;
+	if (tree->arg_ptr[0] != 0 || tree->data_ptr[0] != 0) {
+		return CVXCANON_INVALID_TREE;
+	}
+	for (int i = 0; i < n; i++) {
+		if (tree->type[i] < 0 || tree->type[i] > LAST_OPERATOR_TYPE) {
+			return CVXCANON_INVALID_TREE;
+		}
+		if (tree->size[2 * i] < 0 || tree->size[2 * i + 1] < 0) {
+			return CVXCANON_INVALID_TREE;
+		}
+		if (tree->arg_ptr[i + 1] < tree->arg_ptr[i] ||
+		    tree->data_ptr[i + 1] < tree->data_ptr[i]) {
+			return CVXCANON_INVALID_TREE;
+		}
+		int data_len = tree->data_ptr[i + 1] - tree->data_ptr[i];
+		int data_rows = tree->data_size[2 * i];
+		int data_cols = tree->data_size[2 * i + 1];
+		if (data_rows < 0 || data_cols < 0) {
+			return CVXCANON_INVALID_TREE;
+		}
+		bool sparse = tree->data_sparse != NULL && tree->data_sparse[i];
+		if (sparse) {
+			if (tree->data_row == NULL || tree->data_col == NULL) {
+				return CVXCANON_INVALID_ARGUMENT;
+			}
+			for (int k = tree->data_ptr[i]; k < tree->data_ptr[i + 1]; k++) {
+				if (tree->data_row[k] < 0 || tree->data_row[k] >= data_rows ||
+				    tree->data_col[k] < 0 || tree->data_col[k] >= data_cols) {
+					return CVXCANON_INVALID_TREE;
+				}
+			}
+		} else if ((long) data_rows * data_cols != data_len) {
+			return CVXCANON_INVALID_TREE;
+		}
+		if (tree->type[i] == INDEX && tree->slice == NULL) {
+			return CVXCANON_INVALID_ARGUMENT;
+		}
+	}
+	if (tree->arg_ptr[n] > 0 && tree->arg_idx == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	if (tree->data_ptr[n] > 0 && tree->data_val == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	for (int k = 0; k < tree->arg_ptr[n]; k++) {
+		if (tree->arg_idx[k] < 0 || tree->arg_idx[k] >= n) {
+			return CVXCANON_INVALID_TREE;
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		if (!check_node(tree, i)) {
+			return CVXCANON_INVALID_TREE;
+		}
+	}
+	return CVXCANON_OK;
+}
+
+/**
+ * Fills the data fields of LIN from node I of TREE, mirroring
+ * set_dense_data and set_sparse_data in LinOp.hpp.
+ */
+static void load_node_data(const cvxcanon_tree *tree, int i, LinOp &lin) {
+	int start = tree->data_ptr[i];
+	int end = tree->data_ptr[i + 1];
+	int rows = tree->data_size[2 * i];
+	int cols = tree->data_size[2 * i + 1];
+	if (tree->data_sparse != NULL && tree->data_sparse[i]) {
+		std::vector<Triplet> tripletList;
+		tripletList.reserve(end - start);
+		for (int k = start; k < end; k++) {
+			tripletList.push_back(Triplet(tree->data_row[k], tree->data_col[k],
+			                              tree->data_val[k]));
+		}
+		lin.sparse = true;
+		lin.sparse_data = Matrix(rows, cols);
+		lin.sparse_data.setFromTriplets(tripletList.begin(), tripletList.end());
+		lin.sparse_data.makeCompressed();
+	} else if (end > start) {
+		lin.dense_data = Eigen::Map<const Eigen::MatrixXd>(tree->data_val + start,
+		                                                   rows, cols);
+	}
+	if (tree->type[i] == INDEX) {
+		const int *sl = tree->slice + 6 * i;
+		lin.slice.push_back(std::vector<int>(sl, sl + 3));
+		lin.slice.push_back(std::vector<int>(sl + 3, sl + 6));
+	}
+}
+
+static const std::map<int, int> &get_id_to_col(const cvxcanon_problem *prob) {
+	return prob->single ? prob->data_float.id_to_col : prob->data.id_to_col;
+}
+
+/**
+ * Copies DATA into caller buffers of any floating point type OUT_SCALAR.
+ */
+template <typename Scalar, typename OutScalar>
+static void copy_problem(const ProblemDataT<Scalar> &data, OutScalar *V,
+                         int *I, int *J, OutScalar *const_vec) {
+	if (V != NULL) {
+		std::copy(data.V.begin(), data.V.end(), V);
+	}
+	if (I != NULL) {
+		std::copy(data.I.begin(), data.I.end(), I);
+	}
+	if (J != NULL) {
+		std::copy(data.J.begin(), data.J.end(), J);
+	}
+	if (const_vec != NULL) {
+		std::copy(data.const_vec.begin(), data.const_vec.end(), const_vec);
+	}
+}
+
+/**
+ * Borrows the arrays of DATA.
+ */
+template <typename Scalar>
+static void view_problem(const ProblemDataT<Scalar> &data, const Scalar **V,
+                         const int **I, const int **J,
+                         const Scalar **const_vec) {
+	if (V != NULL) {
+		*V = data.V.empty() ? NULL : &data.V[0];
+	}
+	if (I != NULL) {
+		*I = data.I.empty() ? NULL : &data.I[0];
+	}
+	if (J != NULL) {
+		*J = data.J.empty() ? NULL : &data.J[0];
+	}
+	if (const_vec != NULL) {
+		*const_vec = data.const_vec.empty() ? NULL : &data.const_vec[0];
+	}
+}
+
+/**
+ * Shared implementation of cvxcanon_build and cvxcanon_build_float.
+ */
+static int build_problem(const cvxcanon_tree *tree, int num_constraints,
+                         const int *constraints, const int *constr_offsets,
+                         int num_vars, const int *var_ids, const int *var_cols,
+                         bool single, cvxcanon_problem **out) {
+	if (out == NULL || num_constraints < 0 || num_vars < 0 ||
+	    (num_constraints > 0 && constraints == NULL) ||
+	    (num_vars > 0 && (var_ids == NULL || var_cols == NULL))) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	*out = NULL;
+	int status = check_tree(tree);
+	if (status != CVXCANON_OK) {
+		return status;
+	}
+	std::vector<char> state(tree->num_nodes, 0);
+	for (int c = 0; c < num_constraints; c++) {
+		if (constraints[c] < 0 || constraints[c] >= tree->num_nodes) {
+			return CVXCANON_INVALID_ARGUMENT;
+		}
+		if (!check_acyclic(tree, constraints[c], state)) {
+			return CVXCANON_INVALID_TREE;
+		}
+	}
+
+	/* The rows of the constraints must not overlap, as checked by
+	   get_total_constraint_length */
+	long next_row = 0;
+	for (int c = 0; constr_offsets != NULL && c < num_constraints; c++) {
+		if (constr_offsets[c] < next_row) {
+			return CVXCANON_INVALID_ARGUMENT;
+		}
+		next_row = constr_offsets[c] + node_len(tree, constraints[c]);
+		if (next_row > INT_MAX) {
+			return CVXCANON_INVALID_ARGUMENT;
+		}
+	}
+	for (int v = 0; v < num_vars; v++) {
+		if (var_cols[v] < 0) {
+			return CVXCANON_INVALID_ARGUMENT;
+		}
+	}
+
+	/* The forest owns the nodes for the duration of the call */
+	LinOpForest forest;
+	std::vector<LinOp*> nodes(tree->num_nodes);
+	for (int i = 0; i < tree->num_nodes; i++) {
+		nodes[i] = forest.add_node((OperatorType) tree->type[i],
+		                           tree->size[2 * i], tree->size[2 * i + 1]);
+	}
+	std::map<int, int> var_sizes;
+	for (int i = 0; i < tree->num_nodes; i++) {
+		LinOp &lin = *nodes[i];
+		for (int k = tree->arg_ptr[i]; k < tree->arg_ptr[i + 1]; k++) {
+			lin.args.push_back(nodes[tree->arg_idx[k]]);
+		}
+		load_node_data(tree, i, lin);
+		if (lin.type == VARIABLE) {
+			if (lin.dense_data.size() == 0) {
+				return CVXCANON_INVALID_TREE;
+			}
+			var_sizes[int(lin.dense_data(0, 0))] = lin.size[0] * lin.size[1];
+		}
+	}
+
+	for (int c = 0; c < num_constraints; c++) {
+		forest.add_constraint(nodes[constraints[c]]);
+	}
+	std::map<int, int> id_to_col;
+	for (int v = 0; v < num_vars; v++) {
+		id_to_col[var_ids[v]] = var_cols[v];
+	}
+
+	std::unique_ptr<cvxcanon_problem> prob(new cvxcanon_problem());
+	prob->single = single;
+	std::vector<int> offsets;
+	if (constr_offsets != NULL) {
+		offsets.assign(constr_offsets, constr_offsets + num_constraints);
+	}
+	if (single && constr_offsets == NULL) {
+		prob->data_float = build_matrix_float(forest.constraints, id_to_col);
+	} else if (single) {
+		prob->data_float = build_matrix_float(forest.constraints, id_to_col,
+		                                      offsets);
+	} else if (constr_offsets == NULL) {
+		prob->data = build_matrix(forest.constraints, id_to_col);
+	} else {
+		prob->data = build_matrix(forest.constraints, id_to_col, offsets);
+	}
+
+	/* Columns span every variable that has been assigned an offset */
+	const std::map<int, int> &cols = get_id_to_col(prob.get());
+	prob->num_cols = 0;
+	typedef std::map<int, int>::const_iterator it_type;
+	for (it_type it = cols.begin(); it != cols.end(); ++it) {
+		if (var_sizes.count(it->first)) {
+			prob->num_cols = std::max(prob->num_cols,
+			                          it->second + var_sizes[it->first]);
+		}
+	}
+	*out = prob.release();
+	return CVXCANON_OK;
+}
+
+/**
+ * Runs build_problem without letting an exception cross the C boundary.
+ */
+static int try_build_problem(const cvxcanon_tree *tree, int num_constraints,
+                             const int *constraints,
+                             const int *constr_offsets, int num_vars,
+                             const int *var_ids, const int *var_cols,
+                             bool single, cvxcanon_problem **out) {
+	try {
+		return build_problem(tree, num_constraints, constraints, constr_offsets,
+		                     num_vars, var_ids, var_cols, single, out);
+	} catch (const std::bad_alloc &) {
+		return CVXCANON_OUT_OF_MEMORY;
+	} catch (...) {
+		return CVXCANON_INTERNAL_ERROR;
+	}
+}
+
+extern "C" {
+
+int cvxcanon_build(const cvxcanon_tree *tree, int num_constraints,
+                   const int *constraints, const int *constr_offsets,
+                   int num_vars, const int *var_ids, const int *var_cols,
+                   cvxcanon_problem **out) {
+	return try_build_problem(tree, num_constraints, constraints,
+	                         constr_offsets, num_vars, var_ids, var_cols, false,
+	                         out);
+}
+
+int cvxcanon_build_float(const cvxcanon_tree *tree, int num_constraints,
+                         const int *constraints, const int *constr_offsets,
+                         int num_vars, const int *var_ids, const int *var_cols,
+                         cvxcanon_problem **out) {
+	return try_build_problem(tree, num_constraints, constraints,
+	                         constr_offsets, num_vars, var_ids, var_cols, true,
+	                         out);
+}
+
+int cvxcanon_problem_size(const cvxcanon_problem *prob, int64_t *nnz,
+                          int *num_rows, int *num_cols, int *num_vars) {
+	if (prob == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	if (nnz != NULL) {
+		*nnz = prob->single ? prob->data_float.V.size() : prob->data.V.size();
+	}
+	if (num_rows != NULL) {
+		*num_rows = prob->single ? prob->data_float.const_vec.size()
+		                         : prob->data.const_vec.size();
+	}
+	if (num_cols != NULL) {
+		*num_cols = prob->num_cols;
+	}
+	if (num_vars != NULL) {
+		*num_vars = get_id_to_col(prob).size();
+	}
+	return CVXCANON_OK;
+}
+
+int cvxcanon_problem_copy(const cvxcanon_problem *prob, double *V, int *I,
+                          int *J, double *const_vec) {
+	if (prob == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	if (prob->single) {
+		copy_problem(prob->data_float, V, I, J, const_vec);
+	} else {
+		copy_problem(prob->data, V, I, J, const_vec);
+	}
+	return CVXCANON_OK;
+}
+
+int cvxcanon_problem_copy_float(const cvxcanon_problem *prob, float *V,
+                                int *I, int *J, float *const_vec) {
+	if (prob == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	if (prob->single) {
+		copy_problem(prob->data_float, V, I, J, const_vec);
+	} else {
+		copy_problem(prob->data, V, I, J, const_vec);
+	}
+	return CVXCANON_OK;
+}
+
+int cvxcanon_problem_var_cols(const cvxcanon_problem *prob, int *var_ids,
+                              int *var_cols) {
+	if (prob == NULL || var_ids == NULL || var_cols == NULL) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	const std::map<int, int> &cols = get_id_to_col(prob);
+	int idx = 0;
+	typedef std::map<int, int>::const_iterator it_type;
+	for (it_type it = cols.begin(); it != cols.end(); ++it, ++idx) {
+		var_ids[idx] = it->first;
+		var_cols[idx] = it->second;
+	}
+	return CVXCANON_OK;
+}
+
+int cvxcanon_problem_view(const cvxcanon_problem *prob, const double **V,
+                          const int **I, const int **J,
+                          const double **const_vec) {
+	if (prob == NULL || prob->single) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	view_problem(prob->data, V, I, J, const_vec);
+	return CVXCANON_OK;
+}
+
+int cvxcanon_problem_view_float(const cvxcanon_problem *prob, const float **V,
+                                const int **I, const int **J,
+                                const float **const_vec) {
+	if (prob == NULL || !prob->single) {
+		return CVXCANON_INVALID_ARGUMENT;
+	}
+	view_problem(prob->data_float, V, I, J, const_vec);
+	return CVXCANON_OK;
+}
+
+void cvxcanon_problem_free(cvxcanon_problem *prob) {
+	delete prob;
+}
+
+}
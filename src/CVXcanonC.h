@@ -0,0 +1,175 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stable C interface to CVXcanon.
+ *
+ * LinOp trees are passed as flat arrays (see cvxcanon_tree) and the
+ * problem data is handed back through an opaque handle. Callers first
+ * query the output sizes with cvxcanon_problem_size, allocate V, I, J and
+ * the constant vector themselves, and then fill them with
+ * cvxcanon_problem_copy (or borrow the internal arrays with
+ * cvxcanon_problem_view). No C++ types cross this boundary. */
+
+#ifndef CVXCANON_C_H
+#define CVXCANON_C_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Node types of a cvxcanon_tree. The values are part of the interface and
+ * never change; new types are only added at the end. NO_OP and QUAD_FORM
+ * nodes have no affine coefficient and are rejected by cvxcanon_build. */
+enum cvxcanon_op_type {
+	CVXCANON_OP_VARIABLE = 0,
+	CVXCANON_OP_PROMOTE = 1,
+	CVXCANON_OP_MUL = 2,
+	CVXCANON_OP_RMUL = 3,
+	CVXCANON_OP_MUL_ELEM = 4,
+	CVXCANON_OP_DIV = 5,
+	CVXCANON_OP_SUM = 6,
+	CVXCANON_OP_NEG = 7,
+	CVXCANON_OP_INDEX = 8,
+	CVXCANON_OP_TRANSPOSE = 9,
+	CVXCANON_OP_SUM_ENTRIES = 10,
+	CVXCANON_OP_TRACE = 11,
+	CVXCANON_OP_RESHAPE = 12,
+	CVXCANON_OP_DIAG_VEC = 13,
+	CVXCANON_OP_DIAG_MAT = 14,
+	CVXCANON_OP_UPPER_TRI = 15,
+	CVXCANON_OP_CONV = 16,
+	CVXCANON_OP_HSTACK = 17,
+	CVXCANON_OP_VSTACK = 18,
+	CVXCANON_OP_SCALAR_CONST = 19,
+	CVXCANON_OP_DENSE_CONST = 20,
+	CVXCANON_OP_SPARSE_CONST = 21,
+	CVXCANON_OP_NO_OP = 22,
+	CVXCANON_OP_KRON = 23,
+	CVXCANON_OP_SUM_AXIS = 24,
+	CVXCANON_OP_CUMSUM = 25,
+	CVXCANON_OP_DIFF = 26,
+	CVXCANON_OP_BLOCK_DIAG_MUL = 27,
+	CVXCANON_OP_SVEC = 28,
+	CVXCANON_OP_KRON_RIGHT = 29,
+	CVXCANON_OP_CONV2D = 30,
+	CVXCANON_OP_QUAD_FORM = 31
+};
+
+/* Return codes */
+#define CVXCANON_OK 0
+#define CVXCANON_INVALID_ARGUMENT -1
+#define CVXCANON_INVALID_TREE -2
+#define CVXCANON_OUT_OF_MEMORY -3
+#define CVXCANON_INTERNAL_ERROR -4
+
+/* A forest of LinOps stored as flat arrays. Node i has type TYPE[i] (a
+ * cvxcanon_op_type value) and size SIZE[2 * i] x SIZE[2 * i + 1].
+ *
+ * The children of node i are ARG_IDX[ARG_PTR[i]] ... ARG_IDX[ARG_PTR[i+1]-1].
+ *
+ * The data matrix of node i (constants, divisors, variable ids, ...) has
+ * DATA_SIZE[2 * i] x DATA_SIZE[2 * i + 1] entries and occupies
+ * DATA_VAL[DATA_PTR[i]] ... DATA_VAL[DATA_PTR[i+1]-1]. Dense data is stored
+ * in column major order. If DATA_SPARSE is non-NULL and DATA_SPARSE[i] is
+ * nonzero, the entries of node i are instead COO triplets with row and
+ * column indices DATA_ROW and DATA_COL (indexed like DATA_VAL).
+ *
+ * SLICE may be NULL if the forest has no INDEX nodes. Otherwise it holds
+ * 6 entries per node: (start, stop, step) for the rows followed by
+ * (start, stop, step) for the columns. */
+typedef struct cvxcanon_tree {
+	int num_nodes;
+	const int *type;
+	const int *size;
+	const int *arg_ptr;
+	const int *arg_idx;
+	const int *data_ptr;
+	const int *data_size;
+	const double *data_val;
+	const int *data_sparse;
+	const int *data_row;
+	const int *data_col;
+	const int *slice;
+} cvxcanon_tree;
+
+/* Opaque handle to the result of cvxcanon_build */
+typedef struct cvxcanon_problem cvxcanon_problem;
+
+/* Builds the problem data for the constraint roots CONSTRAINTS (node
+ * indices into TREE). CONSTR_OFFSETS may be NULL, in which case the
+ * constraints are stacked vertically in order. Otherwise the offsets must
+ * be non-negative, increasing and leave room for every constraint. VAR_IDS
+ * and VAR_COLS give NUM_VARS fixed variable offsets, and may be NULL if
+ * NUM_VARS is 0.
+ *
+ * The type, arguments, data and size of every node are checked before
+ * the build, and CVXCANON_INVALID_TREE is returned if they do not fit
+ * together. CVXCANON_OUT_OF_MEMORY and CVXCANON_INTERNAL_ERROR report a
+ * failed allocation or any other error during the build.
+ *
+ * On success *OUT holds a handle which must be released with
+ * cvxcanon_problem_free. */
+int cvxcanon_build(const cvxcanon_tree *tree, int num_constraints,
+                   const int *constraints, const int *constr_offsets,
+                   int num_vars, const int *var_ids, const int *var_cols,
+                   cvxcanon_problem **out);
+
+/* As cvxcanon_build, but stores V and the constant vector in single
+ * precision. Coefficients are still computed in double precision. */
+int cvxcanon_build_float(const cvxcanon_tree *tree, int num_constraints,
+                         const int *constraints, const int *constr_offsets,
+                         int num_vars, const int *var_ids, const int *var_cols,
+                         cvxcanon_problem **out);
+
+/* Size query: number of nonzeros in V/I/J, number of rows (length of the
+ * constant vector), number of columns and number of variables. Any output
+ * pointer may be NULL. */
+int cvxcanon_problem_size(const cvxcanon_problem *prob, int64_t *nnz,
+                          int *num_rows, int *num_cols, int *num_vars);
+
+/* Copies the problem data into caller allocated buffers sized according to
+ * cvxcanon_problem_size. Any output pointer may be NULL to skip it. Values
+ * are converted if the precision of PROB differs from the buffers. */
+int cvxcanon_problem_copy(const cvxcanon_problem *prob, double *V, int *I,
+                          int *J, double *const_vec);
+int cvxcanon_problem_copy_float(const cvxcanon_problem *prob, float *V,
+                                int *I, int *J, float *const_vec);
+
+/* Copies the variable id to column map into caller allocated buffers of
+ * length NUM_VARS. */
+int cvxcanon_problem_var_cols(const cvxcanon_problem *prob, int *var_ids,
+                              int *var_cols);
+
+/* Borrows the internal arrays of PROB without copying. The pointers stay
+ * valid until PROB is freed. cvxcanon_problem_view only applies to
+ * problems from cvxcanon_build and cvxcanon_problem_view_float to problems
+ * from cvxcanon_build_float. */
+int cvxcanon_problem_view(const cvxcanon_problem *prob, const double **V,
+                          const int **I, const int **J,
+                          const double **const_vec);
+int cvxcanon_problem_view_float(const cvxcanon_problem *prob, const float **V,
+                                const int **I, const int **J,
+                                const float **const_vec);
+
+void cvxcanon_problem_free(cvxcanon_problem *prob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
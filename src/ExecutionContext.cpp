@@ -0,0 +1,172 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ExecutionContext.hpp"
+#include "Parallel.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+std::vector<int> get_allowed_cpus() {
+	std::vector<int> cpus;
+#ifdef __linux__
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+#endif
+	return cpus;
+}
+
+/* Reads a sysfs list of the form 0-3,8,10-11. Returns an empty list if
+	 the file does not exist. */
+static std::vector<int> read_list(const std::string &path) {
+	std::vector<int> items;
+	std::ifstream file(path.c_str());
+	std::string range;
+	while (std::getline(file, range, ',')) {
+		int first, last;
+		int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+		if (fields == 1) {
+			last = first;
+		} else if (fields != 2) {
+			continue;
+		}
+		for (int item = first; item <= last; item++) {
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+std::vector<int> get_node_cpus(int node) {
+	std::ostringstream path;
+	path << "/sys/devices/system/node/node" << node << "/cpulist";
+	return read_list(path.str());
+}
+
+std::vector<int> get_memory_nodes() {
+	return read_list("/sys/devices/system/node/has_memory");
+}
+
+ExecutionContext::ExecutionContext()
+	: num_threads(0), pin_threads(false), numa_node(-1),
+	  memory_policy(MEMORY_DEFAULT), huge_pages(false), pool(NULL),
+	  pool_threads(0), pool_pinned(false), pool_node(-1),
+	  page_policy(MEMORY_DEFAULT), page_huge(false), page_node(-1) {}
+
+ExecutionContext::~ExecutionContext() {
+	shutdown();
+}
+
+void ExecutionContext::shutdown() {
+	std::lock_guard<std::mutex> lock(mutex);
+	delete pool;
+	pool = NULL;
+}
+
+void ExecutionContext::set_memory_resource(
+	const std::shared_ptr<MemoryResource> &resource) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->resource = resource;
+}
+
+std::shared_ptr<MemoryResource> ExecutionContext::get_memory_resource() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (resource) {
+		return resource;
+	}
+	if (memory_policy == MEMORY_DEFAULT && !huge_pages) {
+		return new_delete_resource();
+	}
+	if (memory_policy < MEMORY_DEFAULT || memory_policy > MEMORY_NODE) {
+		std::cerr << "Error: invalid memory policy " << memory_policy << std::endl;
+		exit(-1);
+	}
+	if (memory_policy == MEMORY_NODE && numa_node < 0) {
+		std::cerr << "Error: MEMORY_NODE requires a NUMA node." << std::endl;
+		exit(-1);
+	}
+	/* Buffers still in use keep the resource they came from */
+	if (!page_resource || page_policy != memory_policy ||
+	    page_huge != huge_pages || page_node != numa_node) {
+		page_resource.reset(new PageResource(memory_policy, huge_pages,
+		                                     numa_node));
+		page_policy = memory_policy;
+		page_huge = huge_pages;
+		page_node = numa_node;
+	}
+	return page_resource;
+}
+
+ThreadPool *ExecutionContext::get_pool() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (pool != NULL && pool_threads == num_threads &&
+	    pool_pinned == pin_threads && pool_node == numa_node) {
+		return pool;
+	}
+	delete pool;
+	pool = NULL;
+
+	std::vector<int> cpus;
+	if (numa_node >= 0) {
+		cpus = get_node_cpus(numa_node);
+#ifdef __linux__
+		if (cpus.empty()) {
+			std::cerr << "Error: NUMA node " << numa_node << " has no CPUs."
+			          << std::endl;
+			exit(-1);
+		}
+#endif
+	} else if (pin_threads) {
+		cpus = get_allowed_cpus();
+	}
+	int threads = num_threads;
+	if (threads <= 0) {
+		threads = cpus.empty() ? count_cpus() : cpus.size();
+	}
+	pool = new ThreadPool(threads, cpus, pin_threads);
+	pool_threads = num_threads;
+	pool_pinned = pin_threads;
+	pool_node = numa_node;
+	return pool;
+}
+
+ContextScope::ContextScope(ExecutionContext *context)
+	: active(context != NULL) {
+	if (active) {
+		outer_pool = current_pool();
+		outer_resource = current_resource();
+		current_pool() = context->get_pool();
+		current_resource() = context->get_memory_resource();
+	}
+}
+
+ContextScope::~ContextScope() {
+	if (active) {
+		current_pool() = outer_pool;
+		current_resource() = outer_resource;
+	}
+}
@@ -0,0 +1,140 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXECUTIONCONTEXT_H
+#define EXECUTIONCONTEXT_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "MemoryResource.hpp"
+#include "ThreadPool.hpp"
+
+/* Placement of the pages of the buffers allocated by PageResource */
+enum MemoryPolicy {
+	/* Pages go to the NUMA node of the thread that first writes them */
+	MEMORY_DEFAULT,
+	/* Pages are spread round robin over all NUMA nodes with memory, so
+	 * loops running on every socket see the same average bandwidth */
+	MEMORY_INTERLEAVE,
+	/* Pages are placed where a consumer that splits the buffer into one
+	 * contiguous part per NUMA node would first touch them, as a static
+	 * parallel loop whose threads fill the sockets in order does. The
+	 * placement is set when the buffer is mapped, so it does not depend on
+	 * which thread writes the buffer during the build. */
+	MEMORY_FIRST_TOUCH,
+	/* Pages go to ExecutionContext::numa_node if it has free memory */
+	MEMORY_NODE
+};
+
+/* Controls how BUILD_MATRIX runs: how many threads its parallel loops use
+ * and where they run, and which MemoryResource backs V, I and J of the
+ * result and the large temporary arrays of its passes.
+ *
+ * The context owns a pool of worker threads, started on first use and
+ * reused by every later build, so repeated builds do not pay for thread
+ * creation. Builds without a context share one pool of a thread per CPU,
+ * see shared_pool() in Parallel.hpp. Settings changed between builds take effect on the next one;
+ * do not change them while a build is using the context.
+ *
+ * 		ExecutionContext context;
+ * 		context.num_threads = 8;
+ * 		context.numa_node = 0;
+ * 		ProblemData data = build_matrix(constraints, NULL, id_to_col,
+ * 		                                offsets, options, &context);
+ */
+class ExecutionContext {
+public:
+	/* Threads used by the parallel loops, counting the thread that calls
+	 * BUILD_MATRIX. 0 uses one per CPU the process may run on, or per CPU
+	 * of NUMA_NODE. */
+	int num_threads;
+
+	/* Pin each worker thread to its own CPU */
+	bool pin_threads;
+
+	/* If not negative, the workers only run on the CPUs of this NUMA node.
+	 * Linux only; elsewhere it is ignored. */
+	int numa_node;
+
+	/* Placement of the pages of the output buffers, a MemoryPolicy. Any
+	 * policy other than MEMORY_DEFAULT, or HUGE_PAGES, selects a
+	 * PageResource unless a resource was set with set_memory_resource. */
+	int memory_policy;
+
+	/* Back the output buffers with transparent huge pages */
+	bool huge_pages;
+
+	ExecutionContext();
+	~ExecutionContext();
+
+	/* Stops the worker threads. They are started again by the next build. */
+	void shutdown();
+
+#ifndef SWIG
+	/* Resource that backs V, I and J of the results built with this
+	 * context. The default follows MEMORY_POLICY and HUGE_PAGES. */
+	void set_memory_resource(const std::shared_ptr<MemoryResource> &resource);
+	std::shared_ptr<MemoryResource> get_memory_resource();
+
+	/* Returns the worker pool for the current settings, starting it if
+	 * needed */
+	ThreadPool *get_pool();
+
+private:
+	ThreadPool *pool;
+	int pool_threads;
+	bool pool_pinned;
+	int pool_node;
+	std::shared_ptr<MemoryResource> resource;
+	std::shared_ptr<MemoryResource> page_resource;
+	int page_policy;
+	bool page_huge;
+	int page_node;
+	std::mutex mutex;
+#endif
+
+private:
+	/* Not copyable. Declared outside the SWIG guard so the bindings do not
+	 * copy contexts either. */
+	ExecutionContext(const ExecutionContext &);
+	ExecutionContext &operator=(const ExecutionContext &);
+};
+
+#ifndef SWIG
+/* Makes CONTEXT the context of the parallel loops and of the buffers
+ * created on this thread while in scope. A NULL CONTEXT changes nothing. */
+class ContextScope {
+public:
+	ContextScope(ExecutionContext *context);
+	~ContextScope();
+
+private:
+	bool active;
+	ThreadPool *outer_pool;
+	std::shared_ptr<MemoryResource> outer_resource;
+};
+
+/* CPUs the process may run on, in increasing order. Empty if unknown. */
+std::vector<int> get_allowed_cpus();
+
+/* CPUs of NUMA node NODE, in increasing order. Empty if unknown. */
+std::vector<int> get_node_cpus(int node);
+
+/* NUMA nodes that have memory, in increasing order. Empty if unknown. */
+std::vector<int> get_memory_nodes();
+#endif
+
+#endif
@@ -49,7 +49,15 @@ enum operatortype {
 	DENSE_CONST,
 	SPARSE_CONST,
 	NO_OP,
-	KRON
+	KRON,
+	SUM_AXIS,
+	CUMSUM,
+	DIFF,
+	BLOCK_DIAG_MUL,
+	SVEC,
+	KRON_RIGHT,
+	CONV2D,
+	QUAD_FORM
 };
 
 /* linOp TYPE */
@@ -125,5 +133,59 @@ public:
 		sparse_coeffs.makeCompressed();
 		sparse_data = sparse_coeffs;
 	}
+
+	/* Initializes SPARSE_DATA from a sparse matrix in CSC format, as stored
+	 * by scipy.sparse.csc_matrix (DATA, INDICES, INDPTR). ROWS and COLS
+	 * should refer to the size of the matrix.
+	 *
+	 * NOTE: The function prototype must match the type-map in CVXCanon.i
+	 * exactly to compile and run properly.
+	 */
+	void set_sparse_csc(double *csc_data, int csc_data_len, int *csc_indices,
+	                    int csc_indices_len, int *csc_indptr,
+	                    int csc_indptr_len, int rows, int cols) {
+		assert(csc_indices_len == csc_data_len && csc_indptr_len == cols + 1);
+		sparse = true;
+		sparse_data = Eigen::MappedSparseMatrix<double>(rows, cols, csc_data_len,
+		                                                csc_indptr, csc_indices,
+		                                                csc_data);
+		sparse_data.makeCompressed();
+	}
+
+	/* Views of DENSE_DATA and the compressed arrays of SPARSE_DATA that
+	 * share memory with this LinOp. Used to pickle LinOps with out-of-band
+	 * buffers; the views are only valid while this LinOp is alive.
+	 *
+	 * NOTE: The function prototypes must match the type-maps in CVXCanon.i
+	 * exactly to compile and run properly.
+	 */
+	void dense_data_view(double** view_data, int* view_rows, int* view_cols) {
+		*view_data = dense_data.data();
+		*view_rows = dense_data.rows();
+		*view_cols = dense_data.cols();
+	}
+
+	int sparse_data_rows() {
+		return sparse_data.rows();
+	}
+
+	int sparse_data_cols() {
+		return sparse_data.cols();
+	}
+
+	void sparse_data_view(double** view_data, int* view_len) {
+		*view_data = sparse_data.valuePtr();
+		*view_len = sparse_data.nonZeros();
+	}
+
+	void sparse_indices_view(int** idx_view, int* idx_len) {
+		*idx_view = sparse_data.innerIndexPtr();
+		*idx_len = sparse_data.nonZeros();
+	}
+
+	void sparse_indptr_view(int** idx_view, int* idx_len) {
+		*idx_view = sparse_data.outerIndexPtr();
+		*idx_len = sparse_data.outerSize() + 1;
+	}
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,484 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LinOpForest.hpp"
+#include <stdexcept>
+#include <string>
+
+/*******************
+ * HELPER FUNCTIONS
+ *******************/
+
+/**
+ * Throws std::invalid_argument with the message WHAT unless OK. Every
+ * shape check of the typed constructors goes through here.
+ */
+static void check_shape(bool ok, const std::string &what) {
+	if (!ok) {
+		throw std::invalid_argument("LinOpForest: " + what);
+	}
+}
+
+/**
+ * Stores the constant DATA in LIN, as set_dense_data does for Python trees.
+ */
+static void set_data(LinOp &lin, const Eigen::MatrixXd &data) {
+	lin.sparse = false;
+	lin.dense_data = data;
+}
+
+/**
+ * Stores the constant DATA in LIN, as set_sparse_data does for Python trees.
+ */
+static void set_data(LinOp &lin, const Matrix &data) {
+	lin.sparse = true;
+	lin.sparse_data = data;
+	lin.sparse_data.makeCompressed();
+}
+
+/**
+ * Returns the number of elements selected by the python style slice
+ * (START, STOP, STEP), where START and STOP have already been resolved to
+ * non-negative positions as in canonInterface.set_slice_data.
+ */
+static int slice_length(int start, int stop, int step) {
+	check_shape(step != 0, "INDEX slice step must be nonzero");
+	if (step > 0) {
+		return stop > start ? (stop - start + step - 1) / step : 0;
+	}
+	return start > stop ? (start - stop - step - 1) / (-step) : 0;
+}
+
+/**
+ * Returns the size of the product of a ROWS x COLS constant with ARG,
+ * where scalar constants multiply elementwise.
+ */
+static void product_size(int rows, int cols, LinOp *arg, bool left,
+                         int &out_rows, int &out_cols) {
+	if (rows == 1 && cols == 1) {
+		out_rows = arg->size[0];
+		out_cols = arg->size[1];
+	} else if (left) {
+		check_shape(cols == arg->size[0],
+		            "MUL constant columns must match the argument rows");
+		out_rows = rows;
+		out_cols = arg->size[1];
+	} else {
+		check_shape(rows == arg->size[1],
+		            "RMUL constant rows must match the argument columns");
+		out_rows = arg->size[0];
+		out_cols = cols;
+	}
+}
+
+/**
+ * Checks that a ROWS x COLS MUL_ELEM constant is the size of ARG or
+ * broadcasts to it as a scalar, a row or a column.
+ */
+static void check_broadcast(int rows, int cols, LinOp *arg) {
+	check_shape((rows == 1 || rows == arg->size[0]) &&
+	            (cols == 1 || cols == arg->size[1]),
+	            "MUL_ELEM constant does not broadcast to the argument");
+}
+
+/**
+ * Checks that all ARGS of the operator NAME are present and, for SUM, have
+ * the same size, for HSTACK the same rows and for VSTACK the same columns.
+ */
+static void check_args(const std::vector<LinOp*> &args, bool same_rows,
+                       bool same_cols, const std::string &name) {
+	check_shape(!args.empty(), name + " needs at least one argument");
+	for (unsigned i = 1; i < args.size(); i++) {
+		check_shape(!same_rows || args[i]->size[0] == args[0]->size[0],
+		            name + " arguments must have the same number of rows");
+		check_shape(!same_cols || args[i]->size[1] == args[0]->size[1],
+		            name + " arguments must have the same number of columns");
+	}
+}
+
+/*********************
+ * NODE CONSTRUCTION
+ *********************/
+
+LinOp *LinOpForest::add_node(OperatorType type, int rows, int cols,
+                             const std::vector<LinOp*> &args) {
+	nodes.push_back(LinOp());
+	LinOp *lin = &nodes.back();
+	lin->type = type;
+	lin->size.push_back(rows);
+	lin->size.push_back(cols);
+	lin->args = args;
+	return lin;
+}
+
+LinOp *LinOpForest::add_node(OperatorType type, int rows, int cols) {
+	return add_node(type, rows, cols, std::vector<LinOp*>());
+}
+
+LinOp *LinOpForest::unary(OperatorType type, LinOp *arg, int rows,
+                          int cols) {
+	return add_node(type, rows, cols, std::vector<LinOp*>(1, arg));
+}
+
+LinOp *LinOpForest::variable(int id, int rows, int cols) {
+	LinOp *lin = add_node(VARIABLE, rows, cols);
+	set_data(*lin, Eigen::MatrixXd::Constant(1, 1, id));
+	return lin;
+}
+
+LinOp *LinOpForest::scalar_const(double value) {
+	LinOp *lin = add_node(SCALAR_CONST, 1, 1);
+	set_data(*lin, Eigen::MatrixXd::Constant(1, 1, value));
+	return lin;
+}
+
+LinOp *LinOpForest::dense_const(const Eigen::MatrixXd &data) {
+	LinOp *lin = add_node(DENSE_CONST, data.rows(), data.cols());
+	set_data(*lin, data);
+	return lin;
+}
+
+LinOp *LinOpForest::sparse_const(const Matrix &data) {
+	LinOp *lin = add_node(SPARSE_CONST, data.rows(), data.cols());
+	set_data(*lin, data);
+	return lin;
+}
+
+LinOp *LinOpForest::mul(const Eigen::MatrixXd &lhs, LinOp *arg) {
+	int rows, cols;
+	product_size(lhs.rows(), lhs.cols(), arg, true, rows, cols);
+	LinOp *lin = unary(MUL, arg, rows, cols);
+	set_data(*lin, lhs);
+	return lin;
+}
+
+LinOp *LinOpForest::mul(const Matrix &lhs, LinOp *arg) {
+	int rows, cols;
+	product_size(lhs.rows(), lhs.cols(), arg, true, rows, cols);
+	LinOp *lin = unary(MUL, arg, rows, cols);
+	set_data(*lin, lhs);
+	return lin;
+}
+
+LinOp *LinOpForest::rmul(LinOp *arg, const Eigen::MatrixXd &rhs) {
+	int rows, cols;
+	product_size(rhs.rows(), rhs.cols(), arg, false, rows, cols);
+	LinOp *lin = unary(RMUL, arg, rows, cols);
+	set_data(*lin, rhs);
+	return lin;
+}
+
+LinOp *LinOpForest::rmul(LinOp *arg, const Matrix &rhs) {
+	int rows, cols;
+	product_size(rhs.rows(), rhs.cols(), arg, false, rows, cols);
+	LinOp *lin = unary(RMUL, arg, rows, cols);
+	set_data(*lin, rhs);
+	return lin;
+}
+
+LinOp *LinOpForest::mul_elem(const Eigen::MatrixXd &constant, LinOp *arg) {
+	check_broadcast(constant.rows(), constant.cols(), arg);
+	LinOp *lin = unary(MUL_ELEM, arg, arg->size[0], arg->size[1]);
+	set_data(*lin, constant);
+	return lin;
+}
+
+LinOp *LinOpForest::mul_elem(const Matrix &constant, LinOp *arg) {
+	check_broadcast(constant.rows(), constant.cols(), arg);
+	LinOp *lin = unary(MUL_ELEM, arg, arg->size[0], arg->size[1]);
+	set_data(*lin, constant);
+	return lin;
+}
+
+LinOp *LinOpForest::conv(const Eigen::MatrixXd &kernel, LinOp *arg) {
+	check_shape(kernel.cols() == 1 && arg->size[1] == 1,
+	            "CONV kernel and argument must be columns");
+	LinOp *lin = unary(CONV, arg, kernel.rows() + arg->size[0] - 1, 1);
+	set_data(*lin, kernel);
+	return lin;
+}
+
+LinOp *LinOpForest::conv(const Matrix &kernel, LinOp *arg) {
+	check_shape(kernel.cols() == 1 && arg->size[1] == 1,
+	            "CONV kernel and argument must be columns");
+	LinOp *lin = unary(CONV, arg, kernel.rows() + arg->size[0] - 1, 1);
+	set_data(*lin, kernel);
+	return lin;
+}
+
+LinOp *LinOpForest::conv2d(const Eigen::MatrixXd &kernel, LinOp *arg) {
+	LinOp *lin = unary(CONV2D, arg, kernel.rows() + arg->size[0] - 1,
+	                   kernel.cols() + arg->size[1] - 1);
+	set_data(*lin, kernel);
+	return lin;
+}
+
+LinOp *LinOpForest::conv2d(const Matrix &kernel, LinOp *arg) {
+	LinOp *lin = unary(CONV2D, arg, kernel.rows() + arg->size[0] - 1,
+	                   kernel.cols() + arg->size[1] - 1);
+	set_data(*lin, kernel);
+	return lin;
+}
+
+LinOp *LinOpForest::kron(const Eigen::MatrixXd &lhs, LinOp *arg) {
+	LinOp *lin = unary(KRON, arg, lhs.rows() * arg->size[0],
+	                   lhs.cols() * arg->size[1]);
+	set_data(*lin, lhs);
+	return lin;
+}
+
+LinOp *LinOpForest::kron(const Matrix &lhs, LinOp *arg) {
+	LinOp *lin = unary(KRON, arg, lhs.rows() * arg->size[0],
+	                   lhs.cols() * arg->size[1]);
+	set_data(*lin, lhs);
+	return lin;
+}
+
+LinOp *LinOpForest::kron_right(LinOp *arg, const Eigen::MatrixXd &rhs) {
+	LinOp *lin = unary(KRON_RIGHT, arg, arg->size[0] * rhs.rows(),
+	                   arg->size[1] * rhs.cols());
+	set_data(*lin, rhs);
+	return lin;
+}
+
+LinOp *LinOpForest::kron_right(LinOp *arg, const Matrix &rhs) {
+	LinOp *lin = unary(KRON_RIGHT, arg, arg->size[0] * rhs.rows(),
+	                   arg->size[1] * rhs.cols());
+	set_data(*lin, rhs);
+	return lin;
+}
+
+LinOp *LinOpForest::quad_form(LinOp *arg, const Eigen::MatrixXd &Q) {
+	int n = arg->size[0] * arg->size[1];
+	check_shape(Q.rows() == n && Q.cols() == n,
+	            "QUAD_FORM matrix must be square with a row per argument entry");
+	LinOp *lin = unary(QUAD_FORM, arg, 1, 1);
+	set_data(*lin, Q);
+	return lin;
+}
+
+LinOp *LinOpForest::quad_form(LinOp *arg, const Matrix &Q) {
+	int n = arg->size[0] * arg->size[1];
+	check_shape(Q.rows() == n && Q.cols() == n,
+	            "QUAD_FORM matrix must be square with a row per argument entry");
+	LinOp *lin = unary(QUAD_FORM, arg, 1, 1);
+	set_data(*lin, Q);
+	return lin;
+}
+
+LinOp *LinOpForest::sum_squares(LinOp *arg) {
+	int n = arg->size[0] * arg->size[1];
+	Matrix identity(n, n);
+	identity.setIdentity();
+	return quad_form(arg, identity);
+}
+
+LinOp *LinOpForest::div(LinOp *arg, double divisor) {
+	LinOp *lin = unary(DIV, arg, arg->size[0], arg->size[1]);
+	set_data(*lin, Eigen::MatrixXd::Constant(1, 1, divisor));
+	return lin;
+}
+
+/**
+ * Checks that NUM_BLOCKS blocks with COLS columns can multiply the equal
+ * width column blocks of ARG.
+ */
+static void check_blocks(int num_blocks, int cols, LinOp *arg) {
+	check_shape(num_blocks > 0 && cols == arg->size[0] &&
+	            arg->size[1] % num_blocks == 0,
+	            "BLOCK_DIAG_MUL blocks do not fit the argument");
+}
+
+/**
+ * Checks that a BLOCK_ROWS x BLOCK_COLS block has the size ROWS x COLS of
+ * the first block.
+ */
+static void check_block_size(int rows, int cols, int block_rows,
+                             int block_cols) {
+	check_shape(block_rows == rows && block_cols == cols,
+	            "BLOCK_DIAG_MUL blocks must all have the same size");
+}
+
+LinOp *LinOpForest::block_diag_mul(const std::vector<Eigen::MatrixXd> &blocks,
+                                   LinOp *arg) {
+	check_blocks(blocks.size(), blocks.empty() ? 0 : blocks[0].cols(), arg);
+	int rows = blocks[0].rows();
+	int cols = blocks[0].cols();
+	Eigen::MatrixXd data(rows, cols * blocks.size());
+	for (unsigned i = 0; i < blocks.size(); i++) {
+		check_block_size(rows, cols, blocks[i].rows(), blocks[i].cols());
+		data.middleCols(i * cols, cols) = blocks[i];
+	}
+	LinOp *lin = unary(BLOCK_DIAG_MUL, arg, rows, arg->size[1]);
+	set_data(*lin, data);
+	return lin;
+}
+
+LinOp *LinOpForest::block_diag_mul(const std::vector<Matrix> &blocks,
+                                   LinOp *arg) {
+	check_blocks(blocks.size(), blocks.empty() ? 0 : blocks[0].cols(), arg);
+	int rows = blocks[0].rows();
+	int cols = blocks[0].cols();
+	std::vector<Triplet> tripletList;
+	for (unsigned i = 0; i < blocks.size(); i++) {
+		check_block_size(rows, cols, blocks[i].rows(), blocks[i].cols());
+		for (int k = 0; k < blocks[i].outerSize(); ++k) {
+			for (Matrix::InnerIterator it(blocks[i], k); it; ++it) {
+				tripletList.push_back(Triplet(it.row(), i * cols + it.col(),
+				                              it.value()));
+			}
+		}
+	}
+	Matrix data(rows, cols * blocks.size());
+	data.setFromTriplets(tripletList.begin(), tripletList.end());
+	LinOp *lin = unary(BLOCK_DIAG_MUL, arg, rows, arg->size[1]);
+	set_data(*lin, data);
+	return lin;
+}
+
+LinOp *LinOpForest::promote(LinOp *arg, int rows, int cols) {
+	check_shape(arg->size[0] == 1 && arg->size[1] == 1,
+	            "PROMOTE argument must be a scalar");
+	return unary(PROMOTE, arg, rows, cols);
+}
+
+LinOp *LinOpForest::sum(const std::vector<LinOp*> &args) {
+	check_args(args, true, true, "SUM");
+	return add_node(SUM, args[0]->size[0], args[0]->size[1], args);
+}
+
+LinOp *LinOpForest::sum(LinOp *lhs, LinOp *rhs) {
+	std::vector<LinOp*> args;
+	args.push_back(lhs);
+	args.push_back(rhs);
+	return sum(args);
+}
+
+LinOp *LinOpForest::neg(LinOp *arg) {
+	return unary(NEG, arg, arg->size[0], arg->size[1]);
+}
+
+LinOp *LinOpForest::index(LinOp *arg, int row_start, int row_stop,
+                          int row_step, int col_start, int col_stop,
+                          int col_step) {
+	LinOp *lin = unary(INDEX, arg, slice_length(row_start, row_stop, row_step),
+	                   slice_length(col_start, col_stop, col_step));
+	int row_slice[] = {row_start, row_stop, row_step};
+	int col_slice[] = {col_start, col_stop, col_step};
+	lin->slice.push_back(std::vector<int>(row_slice, row_slice + 3));
+	lin->slice.push_back(std::vector<int>(col_slice, col_slice + 3));
+	return lin;
+}
+
+LinOp *LinOpForest::transpose(LinOp *arg) {
+	return unary(TRANSPOSE, arg, arg->size[1], arg->size[0]);
+}
+
+LinOp *LinOpForest::sum_entries(LinOp *arg) {
+	return unary(SUM_ENTRIES, arg, 1, 1);
+}
+
+LinOp *LinOpForest::sum_axis(LinOp *arg, int axis) {
+	check_shape(axis == 0 || axis == 1, "SUM_AXIS axis must be 0 or 1");
+	LinOp *lin;
+	if (axis == 0) {
+		lin = unary(SUM_AXIS, arg, 1, arg->size[1]);
+	} else {
+		lin = unary(SUM_AXIS, arg, arg->size[0], 1);
+	}
+	set_data(*lin, Eigen::MatrixXd::Constant(1, 1, axis));
+	return lin;
+}
+
+LinOp *LinOpForest::cumsum(LinOp *arg, int axis) {
+	check_shape(axis == 0 || axis == 1, "CUMSUM axis must be 0 or 1");
+	LinOp *lin = unary(CUMSUM, arg, arg->size[0], arg->size[1]);
+	set_data(*lin, Eigen::MatrixXd::Constant(1, 1, axis));
+	return lin;
+}
+
+LinOp *LinOpForest::diff(LinOp *arg, int axis, int order) {
+	check_shape(axis == 0 || axis == 1, "DIFF axis must be 0 or 1");
+	check_shape(order >= 0 && order <= arg->size[axis],
+	            "DIFF order must be between 0 and the length of the axis");
+	LinOp *lin;
+	if (axis == 0) {
+		lin = unary(DIFF, arg, arg->size[0] - order, arg->size[1]);
+	} else {
+		lin = unary(DIFF, arg, arg->size[0], arg->size[1] - order);
+	}
+	Eigen::MatrixXd data(1, 2);
+	data << axis, order;
+	set_data(*lin, data);
+	return lin;
+}
+
+LinOp *LinOpForest::trace(LinOp *arg) {
+	check_shape(arg->size[0] == arg->size[1], "TRACE argument must be square");
+	return unary(TRACE, arg, 1, 1);
+}
+
+LinOp *LinOpForest::reshape(LinOp *arg, int rows, int cols) {
+	check_shape(rows * cols == arg->size[0] * arg->size[1],
+	            "RESHAPE must keep the number of entries");
+	return unary(RESHAPE, arg, rows, cols);
+}
+
+LinOp *LinOpForest::diag_vec(LinOp *arg) {
+	check_shape(arg->size[1] == 1, "DIAG_VEC argument must be a column");
+	return unary(DIAG_VEC, arg, arg->size[0], arg->size[0]);
+}
+
+LinOp *LinOpForest::diag_mat(LinOp *arg) {
+	check_shape(arg->size[0] == arg->size[1],
+	            "DIAG_MAT argument must be square");
+	return unary(DIAG_MAT, arg, arg->size[0], 1);
+}
+
+LinOp *LinOpForest::upper_tri(LinOp *arg) {
+	/* Entries strictly above the diagonal, as in get_upper_tri_mat */
+	int rows = arg->size[0];
+	int cols = arg->size[1];
+	int entries = 0;
+	for (int i = 0; i < rows && i + 1 < cols; i++) {
+		entries += cols - i - 1;
+	}
+	return unary(UPPER_TRI, arg, entries, 1);
+}
+
+LinOp *LinOpForest::svec(LinOp *arg) {
+	/* Scaled lower triangle, as in get_svec_mat */
+	int n = arg->size[0];
+	check_shape(n == arg->size[1], "SVEC argument must be square");
+	return unary(SVEC, arg, n * (n + 1) / 2, 1);
+}
+
+LinOp *LinOpForest::hstack(const std::vector<LinOp*> &args) {
+	check_args(args, true, false, "HSTACK");
+	int cols = 0;
+	for (unsigned i = 0; i < args.size(); i++) {
+		cols += args[i]->size[1];
+	}
+	return add_node(HSTACK, args[0]->size[0], cols, args);
+}
+
+LinOp *LinOpForest::vstack(const std::vector<LinOp*> &args) {
+	check_args(args, false, true, "VSTACK");
+	int rows = 0;
+	for (unsigned i = 0; i < args.size(); i++) {
+		rows += args[i]->size[0];
+	}
+	return add_node(VSTACK, rows, args[0]->size[1], args);
+}
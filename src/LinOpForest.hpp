@@ -0,0 +1,134 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LINOPFOREST_H
+#define LINOPFOREST_H
+
+#include <deque>
+#include <vector>
+#include "LinOp.hpp"
+#include "Utils.hpp"
+
+/* Owns a collection of LinOp trees built from C++.
+ *
+ * Nodes are stored in chunked contiguous storage and are never moved, so
+ * the LinOp pointers handed out stay valid until the forest is destroyed.
+ * Only the LinOp structs themselves are pooled: each node still allocates
+ * its SIZE and ARGS vectors and its constant data on the heap, since
+ * LinOp owns them by value.
+ *
+ * Each typed constructor below creates one node, sets its SIZE and data
+ * the same way canonInterface.py does for Python trees, and returns it.
+ * A constructor whose arguments, constant or parameters do not fit
+ * together throws std::invalid_argument and adds no node.
+ *
+ * 		LinOpForest forest;
+ * 		LinOp *x = forest.variable(0, n, 1);
+ * 		LinOp *expr = forest.sum(forest.mul(A, x), forest.dense_const(b));
+ * 		forest.add_constraint(expr);
+ * 		ProblemData data = build_matrix(forest.constraints, id_to_col);
+ */
+class LinOpForest {
+public:
+	/* Roots of the constraint trees, in the order passed to BUILD_MATRIX */
+	std::vector<LinOp*> constraints;
+
+	LinOpForest() {}
+
+	/* Generic node constructor used by the typed constructors below */
+	LinOp *add_node(OperatorType type, int rows, int cols,
+	                const std::vector<LinOp*> &args);
+	LinOp *add_node(OperatorType type, int rows, int cols);
+
+	void add_constraint(LinOp *root) {
+		constraints.push_back(root);
+	}
+
+	/* Number of nodes owned by the forest */
+	int size() const {
+		return nodes.size();
+	}
+
+	/* Leaves */
+	LinOp *variable(int id, int rows, int cols);
+	LinOp *scalar_const(double value);
+	LinOp *dense_const(const Eigen::MatrixXd &data);
+	LinOp *sparse_const(const Matrix &data);
+
+	/* Operators with constant data. The constant is copied into the node.
+	 * The MUL_ELEM constant may also be a scalar, a row or a column, which
+	 * is broadcast to the size of ARG. */
+	LinOp *mul(const Eigen::MatrixXd &lhs, LinOp *arg);
+	LinOp *mul(const Matrix &lhs, LinOp *arg);
+	LinOp *rmul(LinOp *arg, const Eigen::MatrixXd &rhs);
+	LinOp *rmul(LinOp *arg, const Matrix &rhs);
+	LinOp *mul_elem(const Eigen::MatrixXd &constant, LinOp *arg);
+	LinOp *mul_elem(const Matrix &constant, LinOp *arg);
+	LinOp *conv(const Eigen::MatrixXd &kernel, LinOp *arg);
+	LinOp *conv(const Matrix &kernel, LinOp *arg);
+	LinOp *conv2d(const Eigen::MatrixXd &kernel, LinOp *arg);
+	LinOp *conv2d(const Matrix &kernel, LinOp *arg);
+	LinOp *kron(const Eigen::MatrixXd &lhs, LinOp *arg);
+	LinOp *kron(const Matrix &lhs, LinOp *arg);
+	LinOp *kron_right(LinOp *arg, const Eigen::MatrixXd &rhs);
+	LinOp *kron_right(LinOp *arg, const Matrix &rhs);
+	LinOp *div(LinOp *arg, double divisor);
+
+	/* Quadratic terms for BUILD_QUAD_MATRIX. QUAD_FORM is x^T Q x for the
+	 * entries x of ARG in column major order; SUM_SQUARES uses Q = I. The
+	 * result is a scalar and is not an affine expression. */
+	LinOp *quad_form(LinOp *arg, const Eigen::MatrixXd &Q);
+	LinOp *quad_form(LinOp *arg, const Matrix &Q);
+	LinOp *sum_squares(LinOp *arg);
+
+	/* Multiplies the I-th of BLOCKS.size() equal width column blocks of ARG
+	 * by BLOCKS[I]. All blocks must have the same size, with as many columns
+	 * as ARG has rows, and their number must divide the columns of ARG. */
+	LinOp *block_diag_mul(const std::vector<Eigen::MatrixXd> &blocks,
+	                      LinOp *arg);
+	LinOp *block_diag_mul(const std::vector<Matrix> &blocks, LinOp *arg);
+
+	/* Structural operators */
+	LinOp *promote(LinOp *arg, int rows, int cols);
+	LinOp *sum(const std::vector<LinOp*> &args);
+	LinOp *sum(LinOp *lhs, LinOp *rhs);
+	LinOp *neg(LinOp *arg);
+	LinOp *index(LinOp *arg, int row_start, int row_stop, int row_step,
+	             int col_start, int col_stop, int col_step);
+	LinOp *transpose(LinOp *arg);
+	LinOp *sum_entries(LinOp *arg);
+	LinOp *sum_axis(LinOp *arg, int axis);
+	LinOp *cumsum(LinOp *arg, int axis);
+	LinOp *diff(LinOp *arg, int axis, int order);
+	LinOp *trace(LinOp *arg);
+	LinOp *reshape(LinOp *arg, int rows, int cols);
+	LinOp *diag_vec(LinOp *arg);
+	LinOp *diag_mat(LinOp *arg);
+	LinOp *upper_tri(LinOp *arg);
+	LinOp *svec(LinOp *arg);
+	LinOp *hstack(const std::vector<LinOp*> &args);
+	LinOp *vstack(const std::vector<LinOp*> &args);
+
+private:
+	std::deque<LinOp> nodes;
+
+	/* Nodes point into NODES, so forests cannot be copied */
+	LinOpForest(const LinOpForest &);
+	LinOpForest &operator=(const LinOpForest &);
+
+	LinOp *unary(OperatorType type, LinOp *arg, int rows, int cols);
+};
+
+#endif
@@ -15,10 +15,14 @@
 
 #include "LinOp.hpp"
 #include "LinOpOperations.hpp"
+#include "Parallel.hpp"
 #include "Utils.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <map>
 #include <iostream>
+#include <utility>
 
 /***********************
  * FUNCTION PROTOTYPES *
@@ -43,6 +47,20 @@ std::vector<Matrix> get_conv_mat(LinOp &lin);
 std::vector<Matrix> get_hstack_mat(LinOp &lin);
 std::vector<Matrix> get_vstack_mat(LinOp &lin);
 std::vector<Matrix> get_kron_mat(LinOp &lin);
+std::vector<Matrix> get_kron_right_mat(LinOp &lin);
+Matrix apply_kron_right(LinOp &lin, Matrix &rh);
+std::vector<Matrix> get_conv2d_mat(LinOp &lin);
+Matrix apply_conv2d(LinOp &lin, Matrix &rh);
+std::vector<Matrix> get_sum_axis_mat(LinOp &lin);
+Matrix apply_sum_axis(LinOp &lin, Matrix &rh);
+std::vector<Matrix> get_cumsum_mat(LinOp &lin);
+Matrix apply_cumsum(LinOp &lin, Matrix &rh);
+std::vector<Matrix> get_diff_mat(LinOp &lin);
+Matrix apply_diff(LinOp &lin, Matrix &rh);
+Matrix apply_mul_elemwise(LinOp &lin, Matrix &rh);
+std::vector<Matrix> get_block_diag_mul_mat(LinOp &lin);
+std::vector<Matrix> get_svec_mat(LinOp &lin);
+Matrix apply_svec(LinOp &lin, Matrix &rh);
 
 /**
  * Computes a vector of coefficient matrices for the linOp LIN based on the
@@ -116,6 +134,31 @@ std::vector<Matrix> get_func_coeffs(LinOp& lin) {
 	case KRON:
 		coeffs = get_kron_mat(lin);
 		break;
+	case KRON_RIGHT:
+		coeffs = get_kron_right_mat(lin);
+		break;
+	case CONV2D:
+		coeffs = get_conv2d_mat(lin);
+		break;
+	case SUM_AXIS:
+		coeffs = get_sum_axis_mat(lin);
+		break;
+	case CUMSUM:
+		coeffs = get_cumsum_mat(lin);
+		break;
+	case DIFF:
+		coeffs = get_diff_mat(lin);
+		break;
+	case BLOCK_DIAG_MUL:
+		coeffs = get_block_diag_mul_mat(lin);
+		break;
+	case SVEC:
+		coeffs = get_svec_mat(lin);
+		break;
+	case QUAD_FORM:
+		std::cerr << "Error: QUAD_FORM is not affine, pass it to "
+		          << "build_quad_matrix." << std::endl;
+		exit(-1);
 	default:
 		std::cerr << "Error: linOp type invalid." << std::endl;
 		exit(-1);
@@ -123,16 +166,70 @@ std::vector<Matrix> get_func_coeffs(LinOp& lin) {
 	return coeffs;
 }
 
+/**
+ * Returns true if the coefficients of LIN can be applied with
+ * APPLY_FUNC_COEFF instead of being built by GET_FUNC_COEFFS.
+ */
+bool has_func_apply(LinOp &lin) {
+	switch (lin.type) {
+	case MUL_ELEM:
+	case SUM_AXIS:
+	case CUMSUM:
+	case DIFF:
+	case SVEC:
+	case KRON_RIGHT:
+	case CONV2D:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Returns the coefficient of argument ARG_IDX of LIN multiplied by RH, the
+ * coefficient of that argument for one variable (or the constant).
+ * Equivalent to get_func_coeffs(lin)[arg_idx] * rh, in time proportional to
+ * the nonzeros of RH.
+ *
+ * Parameters: LinOp node LIN with has_func_apply(LIN), argument index
+ * 						 ARG_IDX and sparse matrix RH with one row per entry of the argument.
+ *
+ * Returns: sparse product matrix
+ */
+Matrix apply_func_coeff(LinOp &lin, int arg_idx, Matrix &rh) {
+	assert(arg_idx >= 0 && arg_idx < (int) lin.args.size());
+	switch (lin.type) {
+	case MUL_ELEM:
+		return apply_mul_elemwise(lin, rh);
+	case SUM_AXIS:
+		return apply_sum_axis(lin, rh);
+	case CUMSUM:
+		return apply_cumsum(lin, rh);
+	case DIFF:
+		return apply_diff(lin, rh);
+	case SVEC:
+		return apply_svec(lin, rh);
+	case KRON_RIGHT:
+		return apply_kron_right(lin, rh);
+	case CONV2D:
+		return apply_conv2d(lin, rh);
+	default:
+		std::cerr << "Error: linOp type has no coefficient apply." << std::endl;
+		exit(-1);
+	}
+}
+
 /*******************
  * HELPER FUNCTIONS
  *******************/
 
 /**
- * Returns a vector containing the sparse matrix MAT
+ * Returns a vector containing the sparse matrix MAT. MAT is swapped into
+ * the vector rather than copied, and is left empty.
  */
 std::vector<Matrix> build_vector(Matrix &mat) {
-	std::vector<Matrix> vec;
-	vec.push_back(mat);
+	std::vector<Matrix> vec(1);
+	vec[0].swap(mat);
 	return vec;
 }
 
@@ -158,6 +255,129 @@ Matrix sparse_ones(int rows, int cols)
 	return mat;
 }
 
+/**
+ * Returns the matrix with OUT_ROWS rows whose row ROW_MAP(i) is the sum of
+ * the rows i of MAT mapped to it. Used by the linOps whose coefficient is a
+ * 0/1 matrix with a single 1 per column, to apply it in O(nnz(MAT)).
+ */
+template <typename RowMap>
+Matrix sum_rows(Matrix &mat, int out_rows, RowMap row_map) {
+	std::vector<Triplet> tripletList;
+	tripletList.reserve(mat.nonZeros());
+	for ( int k = 0; k < mat.outerSize(); ++k ) {
+		for ( Matrix::InnerIterator it(mat, k); it; ++it ) {
+			tripletList.push_back(Triplet(row_map(it.row()), it.col(), it.value()));
+		}
+	}
+	Matrix out(out_rows, mat.cols());
+	out.setFromTriplets(tripletList.begin(), tripletList.end());
+	out.makeCompressed();
+	return out;
+}
+
+/**
+ * Returns the OUT_ROWS by NUM_IN coefficient whose column IDX holds entry
+ * (A, B) of CONSTANT in row ROW_MAP(IDX, A, B). Used by the linOps that
+ * spread every argument entry over a copy of their constant data.
+ *
+ * ROW_MAP must increase with B and then with A for a fixed IDX, so each
+ * column comes out sorted; the coefficient is then written directly in
+ * compressed column form, in parallel over its columns.
+ */
+template <typename RowMap>
+Matrix spread_coeffs(Matrix &constant, int num_in, int out_rows,
+                     RowMap row_map) {
+	int const_nnz = constant.nonZeros();
+	Matrix coeffs(out_rows, num_in);
+	int *outer = coeffs.outerIndexPtr();
+	for (int idx = 0; idx <= num_in; idx++) {
+		outer[idx] = idx * const_nnz;
+	}
+	coeffs.resizeNonZeros((long) num_in * const_nnz);
+
+	int *inner = coeffs.innerIndexPtr();
+	double *values = coeffs.valuePtr();
+	int num_chunks = get_num_chunks((long) num_in * const_nnz);
+	parallel_chunks(num_in, num_chunks, [&](int, long begin, long end) {
+		for (long idx = begin; idx < end; idx++) {
+			int dest = outer[idx];
+			for (int b = 0; b < constant.outerSize(); b++) {
+				for (Matrix::InnerIterator it(constant, b); it; ++it) {
+					inner[dest] = row_map(idx, it.row(), b);
+					values[dest] = it.value();
+					dest++;
+				}
+			}
+		}
+	});
+	return coeffs;
+}
+
+/**
+ * Returns the OUT_ROWS by NUM_COLS matrix whose column K is column
+ * SRC_COL(K) of SRC, with its entry in row R moved to row ROW_MAP(K, R).
+ * Used by the linOps whose coefficient is a block pattern of copies of
+ * their constant data.
+ *
+ * ROW_MAP must increase with R for a fixed K. The column counts are summed
+ * first, so every column owns a known range of the output arrays and the
+ * columns are filled in parallel.
+ */
+template <typename SrcCol, typename RowMap>
+Matrix copy_columns(Matrix &src, int out_rows, int num_cols, SrcCol src_col,
+                    RowMap row_map) {
+	src.makeCompressed();
+	const int *src_outer = src.outerIndexPtr();
+	Matrix coeffs(out_rows, num_cols);
+	int *outer = coeffs.outerIndexPtr();
+	outer[0] = 0;
+	for (int k = 0; k < num_cols; k++) {
+		int col = src_col(k);
+		outer[k + 1] = outer[k] + src_outer[col + 1] - src_outer[col];
+	}
+	coeffs.resizeNonZeros(outer[num_cols]);
+
+	int *inner = coeffs.innerIndexPtr();
+	double *values = coeffs.valuePtr();
+	int num_chunks = get_num_chunks(outer[num_cols]);
+	parallel_chunks(num_cols, num_chunks, [&](int, long begin, long end) {
+		for (long k = begin; k < end; k++) {
+			int dest = outer[k];
+			for (Matrix::InnerIterator it(src, src_col(k)); it; ++it) {
+				inner[dest] = row_map(k, it.row());
+				values[dest] = it.value();
+				dest++;
+			}
+		}
+	});
+	return coeffs;
+}
+
+/**
+ * Returns the product of the coefficient of SPREAD_COEFFS with MAT without
+ * forming the coefficient, in O(nnz(MAT) * nnz(CONSTANT)).
+ */
+template <typename RowMap>
+Matrix spread_rows(Matrix &mat, Matrix &constant, int out_rows,
+                   RowMap row_map) {
+	std::vector<Triplet> tripletList;
+	tripletList.reserve(mat.nonZeros() * constant.nonZeros());
+	for ( int k = 0; k < mat.outerSize(); ++k ) {
+		for ( Matrix::InnerIterator x(mat, k); x; ++x ) {
+			for (int b = 0; b < constant.outerSize(); b++) {
+				for (Matrix::InnerIterator it(constant, b); it; ++it) {
+					tripletList.push_back(Triplet(row_map(x.row(), it.row(), b), k,
+					                              x.value() * it.value()));
+				}
+			}
+		}
+	}
+	Matrix out(out_rows, mat.cols());
+	out.setFromTriplets(tripletList.begin(), tripletList.end());
+	out.makeCompressed();
+	return out;
+}
+
 /**
  * Reshapes the input matrix into a single column vector that preserves
  * columnwise ordering. Equivalent to Matlab's (:) operation.
@@ -202,11 +422,11 @@ Matrix sparse_reshape_to_vec(Matrix &mat) {
  *
  */
 std::vector<Matrix> stack_matrices(LinOp &lin, bool vertical) {
-	std::vector<Matrix> coeffs_mats;
 	int offset = 0;
 	int num_args = lin.args.size();
+	std::vector<Matrix> coeffs_mats(num_args);
 	for (int idx = 0; idx < num_args; idx++) {
-		LinOp arg = *lin.args[idx];
+		LinOp &arg = *lin.args[idx];
 
 		/* If VERTICAL, columns that are interleaved. Otherwise, they are
 			 laid out in order. */
@@ -220,20 +440,24 @@ std::vector<Matrix> stack_matrices(LinOp &lin, bool vertical) {
 			offset_increment = arg.size[0] * arg.size[1];
 		}
 
-		std::vector<Triplet> tripletList;
-		tripletList.reserve(arg.size[0] * arg.size[1]);
-		for (int i = 0; i < arg.size[0]; i++) {
-			for (int j = 0; j < arg.size[1]; j++) {
-				int row_idx = i + (j * column_offset) + offset;
-				int col_idx = i + (j * arg.size[0]);
-				tripletList.push_back(Triplet(row_idx, col_idx, 1));
+		/* Column I + J * ROWS holds a single 1, in row
+			 I + J * COLUMN_OFFSET + OFFSET, so it is written in place. */
+		int rows = arg.size[0];
+		int num_cols = arg.size[0] * arg.size[1];
+		Matrix &coeff = coeffs_mats[idx];
+		coeff.resize(lin.size[0] * lin.size[1], num_cols);
+		coeff.resizeNonZeros(num_cols);
+		int *outer = coeff.outerIndexPtr();
+		int *inner = coeff.innerIndexPtr();
+		double *values = coeff.valuePtr();
+		outer[num_cols] = num_cols;
+		parallel_for(num_cols, [&](long begin, long end) {
+			for (long col = begin; col < end; col++) {
+				outer[col] = col;
+				inner[col] = col % rows + (col / rows) * column_offset + offset;
+				values[col] = 1;
 			}
-		}
-
-		Matrix coeff(lin.size[0] * lin.size[1], arg.size[0] * arg.size[1]);
-		coeff.setFromTriplets(tripletList.begin(), tripletList.end());
-		coeff.makeCompressed();
-		coeffs_mats.push_back(coeff);
+		});
 		offset += offset_increment;
 	}
 	return coeffs_mats;
@@ -284,6 +508,31 @@ Matrix get_constant_data(LinOp &lin, bool column) {
 	return coeffs;
 }
 
+/**
+ * Returns the symmetric part of the constant of a QUAD_FORM linOp, which
+ * represents x^T Q x for its argument x read in column major order. Only
+ * the symmetric part of Q contributes to the quadratic form.
+ *
+ * Params: LinOp LIN with type QUAD_FORM and an N x N constant, where N is
+ * 				 the number of entries of its argument.
+ *
+ * Returns: sparse eigen matrix (Q + Q^T) / 2
+ */
+Matrix get_quad_form_mat(LinOp &lin) {
+	assert(lin.type == QUAD_FORM);
+	Matrix constant = get_constant_data(lin, false);
+	int n = lin.args[0]->size[0] * lin.args[0]->size[1];
+	if (constant.rows() != n || constant.cols() != n) {
+		std::cerr << "Error: QUAD_FORM constant must be " << n << " x " << n
+		          << "." << std::endl;
+		exit(-1);
+	}
+	Matrix transposed = constant.transpose();
+	Matrix sym = 0.5 * (constant + transposed);
+	sym.makeCompressed();
+	return sym;
+}
+
 /**
  * Interface for the INDEX linOp to retrieve slice data. Assumes that the
  * INDEX linOp stores slice data in the following format
@@ -331,6 +580,49 @@ double get_divisor_data(LinOp &lin) {
 	return lin.dense_data(0, 0);
 }
 
+/**
+ * Interface for the SUM_AXIS, CUMSUM and DIFF linOps to retrieve the axis
+ * they operate along.
+ *
+ * Parameters: linOp LIN with the axis stored in the 0,0 component of the
+ * 							DENSE_DATA matrix. Axis 0 runs down each column and axis 1
+ * 							along each row, so SUM_AXIS over axis 0 gives a 1 x COLS
+ * 							result and over axis 1 a ROWS x 1 result.
+ *
+ * Returns: integer axis
+ */
+int get_axis_data(LinOp &lin) {
+	assert(lin.type == SUM_AXIS || lin.type == CUMSUM || lin.type == DIFF);
+	int axis = int(lin.dense_data(0, 0));
+	if (axis != 0 && axis != 1) {
+		std::cerr << "Error: linOp axis must be 0 or 1." << std::endl;
+		exit(-1);
+	}
+	return axis;
+}
+
+/**
+ * Interface for the DIFF linOp to retrieve the order of the difference.
+ *
+ * Parameters: linOp LIN of type DIFF with the order stored in the 0,1
+ * 							component of the DENSE_DATA matrix. If DENSE_DATA has a
+ * 							single entry the order is 1.
+ *
+ * Returns: integer order
+ */
+int get_diff_order(LinOp &lin) {
+	assert(lin.type == DIFF);
+	if (lin.dense_data.size() < 2) {
+		return 1;
+	}
+	int order = int(lin.dense_data(0, 1));
+	if (order < 0) {
+		std::cerr << "Error: DIFF order must be non-negative." << std::endl;
+		exit(-1);
+	}
+	return order;
+}
+
 /**
  * Interface for the VARIABLE linOp to retrieve its variable ID.
  *
@@ -348,7 +640,272 @@ int get_id_data(LinOp &lin) {
  * LinOP -> Matrix FUNCTIONS
  *****************************/
 /**
- * Return the coefficients for KRON.
+ * Return the coefficients for SUM_AXIS: a 0/1 matrix with one 1 per column,
+ * which maps entry (i, j) of the argument to entry j of the result for
+ * AXIS 0 and to entry i for AXIS 1.
+ *
+ * Parameters: linOp LIN with type SUM_AXIS
+ * Returns: vector containing the coefficient matrix COEFFS
+ */
+std::vector<Matrix> get_sum_axis_mat(LinOp &lin) {
+	assert(lin.type == SUM_AXIS);
+	int rows = lin.args[0]->size[0];
+	int cols = lin.args[0]->size[1];
+	int axis = get_axis_data(lin);
+
+	Matrix coeffs(lin.size[0] * lin.size[1], rows * cols);
+	std::vector<Triplet> tripletList;
+	tripletList.reserve(rows * cols);
+	for (int j = 0; j < cols; j++) {
+		for (int i = 0; i < rows; i++) {
+			int row_idx = (axis == 0) ? j : i;
+			tripletList.push_back(Triplet(row_idx, j * rows + i, 1.0));
+		}
+	}
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return build_vector(coeffs);
+}
+
+/**
+ * Applies the SUM_AXIS coefficient to RH by summing its rows directly.
+ *
+ * Parameters: linOp LIN with type SUM_AXIS, sparse matrix RH
+ * Returns: the product of the SUM_AXIS coefficient and RH
+ */
+Matrix apply_sum_axis(LinOp &lin, Matrix &rh) {
+	assert(lin.type == SUM_AXIS);
+	int rows = lin.args[0]->size[0];
+	int out_rows = lin.size[0] * lin.size[1];
+	if (get_axis_data(lin) == 0) {
+		return sum_rows(rh, out_rows, [rows](int idx) { return idx / rows; });
+	}
+	return sum_rows(rh, out_rows, [rows](int idx) { return idx % rows; });
+}
+
+/**
+ * Index arithmetic for the linOps that work along one AXIS of a ROWS x COLS
+ * matrix (CUMSUM, DIFF). Entry (i, j), at position j * ROWS + i of the
+ * vectorized matrix, lies on line j at position i for axis 0 and on line i
+ * at position j for axis 1.
+ */
+class AxisIndex {
+public:
+	int axis;
+	int rows;
+	int cols;
+
+	AxisIndex(int axis, int rows, int cols)
+		: axis(axis), rows(rows), cols(cols) {}
+
+	int num_lines() const {
+		return axis == 0 ? cols : rows;
+	}
+
+	int line_length() const {
+		return axis == 0 ? rows : cols;
+	}
+
+	int line(int idx) const {
+		return axis == 0 ? idx / rows : idx % rows;
+	}
+
+	int pos(int idx) const {
+		return axis == 0 ? idx % rows : idx / rows;
+	}
+
+	/* Vectorized index of position POS of line LINE, when lines along the
+	   axis have LENGTH entries */
+	int index(int line, int pos, int length) const {
+		return axis == 0 ? line * length + pos : pos * rows + line;
+	}
+};
+
+/**
+ * Returns the weights of the ORDER-th forward difference,
+ * (-1)^(ORDER - t) * binomial(ORDER, t) for t = 0, ..., ORDER.
+ */
+std::vector<double> get_diff_weights(int order) {
+	std::vector<double> weights(order + 1, 0);
+	weights[0] = 1;
+	for (int k = 1; k <= order; k++) {
+		for (int t = k; t > 0; t--) {
+			weights[t] = weights[t - 1] - weights[t];
+		}
+		weights[0] = -weights[0];
+	}
+	return weights;
+}
+
+/**
+ * Return the coefficients for CUMSUM: a block lower triangular 0/1 matrix
+ * where entry p of each line along the axis is the sum of entries 0..p of
+ * that line.
+ *
+ * Parameters: linOp LIN with type CUMSUM
+ * Returns: vector containing the coefficient matrix COEFFS
+ */
+std::vector<Matrix> get_cumsum_mat(LinOp &lin) {
+	assert(lin.type == CUMSUM);
+	AxisIndex ax(get_axis_data(lin), lin.size[0], lin.size[1]);
+	int n = lin.size[0] * lin.size[1];
+	int len = ax.line_length();
+
+	Matrix coeffs(n, n);
+	std::vector<Triplet> tripletList;
+	tripletList.reserve((long) ax.num_lines() * len * (len + 1) / 2);
+	for (int line = 0; line < ax.num_lines(); line++) {
+		for (int q = 0; q < len; q++) {
+			int col_idx = ax.index(line, q, len);
+			for (int p = q; p < len; p++) {
+				tripletList.push_back(Triplet(ax.index(line, p, len), col_idx, 1.0));
+			}
+		}
+	}
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return build_vector(coeffs);
+}
+
+/**
+ * Applies the CUMSUM coefficient to RH with a running sum along each line,
+ * per column of RH. The work is proportional to the nonzeros of the
+ * result, which starts at the first nonzero of each line.
+ *
+ * Parameters: linOp LIN with type CUMSUM, sparse matrix RH
+ * Returns: the product of the CUMSUM coefficient and RH
+ */
+Matrix apply_cumsum(LinOp &lin, Matrix &rh) {
+	assert(lin.type == CUMSUM);
+	AxisIndex ax(get_axis_data(lin), lin.size[0], lin.size[1]);
+	int len = ax.line_length();
+
+	std::vector<Triplet> tripletList;
+	std::vector<std::pair<long, double> > entries;
+	for (int k = 0; k < rh.outerSize(); ++k) {
+		/* Sort the entries of this column by line, then position */
+		entries.clear();
+		for (Matrix::InnerIterator it(rh, k); it; ++it) {
+			long key = (long) ax.line(it.row()) * len + ax.pos(it.row());
+			entries.push_back(std::make_pair(key, it.value()));
+		}
+		std::sort(entries.begin(), entries.end());
+
+		unsigned e = 0;
+		while (e < entries.size()) {
+			int line = entries[e].first / len;
+			double sum = 0;
+			for (int p = entries[e].first % len; p < len; p++) {
+				if (e < entries.size() && entries[e].first == (long) line * len + p) {
+					sum += entries[e].second;
+					e++;
+				}
+				tripletList.push_back(Triplet(ax.index(line, p, len), k, sum));
+			}
+		}
+	}
+	Matrix coeffs(rh.rows(), rh.cols());
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return coeffs;
+}
+
+/**
+ * Return the coefficients for DIFF: a banded matrix where entry p of each
+ * line of the result is the ORDER-th forward difference of entries
+ * p..p+ORDER of the argument's line, with ORDER + 1 nonzeros per row.
+ *
+ * Parameters: linOp LIN with type DIFF
+ * Returns: vector containing the coefficient matrix COEFFS
+ */
+std::vector<Matrix> get_diff_mat(LinOp &lin) {
+	assert(lin.type == DIFF);
+	int rows = lin.args[0]->size[0];
+	int cols = lin.args[0]->size[1];
+	AxisIndex ax(get_axis_data(lin), rows, cols);
+	std::vector<double> weights = get_diff_weights(get_diff_order(lin));
+	int order = weights.size() - 1;
+	int len = ax.line_length();
+	int out_len = std::max(len - order, 0);
+
+	Matrix coeffs(lin.size[0] * lin.size[1], rows * cols);
+	std::vector<Triplet> tripletList;
+	tripletList.reserve((long) ax.num_lines() * out_len * (order + 1));
+	for (int line = 0; line < ax.num_lines(); line++) {
+		for (int p = 0; p < out_len; p++) {
+			int row_idx = ax.index(line, p, out_len);
+			for (int t = 0; t <= order; t++) {
+				tripletList.push_back(Triplet(row_idx, ax.index(line, p + t, len),
+				                              weights[t]));
+			}
+		}
+	}
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return build_vector(coeffs);
+}
+
+/**
+ * Applies the DIFF coefficient to RH. Each entry of RH contributes to at
+ * most ORDER + 1 entries of the result, so the work is O(nnz(RH) * ORDER).
+ *
+ * Parameters: linOp LIN with type DIFF, sparse matrix RH
+ * Returns: the product of the DIFF coefficient and RH
+ */
+Matrix apply_diff(LinOp &lin, Matrix &rh) {
+	assert(lin.type == DIFF);
+	AxisIndex ax(get_axis_data(lin), lin.args[0]->size[0],
+	             lin.args[0]->size[1]);
+	std::vector<double> weights = get_diff_weights(get_diff_order(lin));
+	int order = weights.size() - 1;
+	int out_len = std::max(ax.line_length() - order, 0);
+
+	std::vector<Triplet> tripletList;
+	tripletList.reserve(rh.nonZeros() * (order + 1));
+	for (int k = 0; k < rh.outerSize(); ++k) {
+		for (Matrix::InnerIterator it(rh, k); it; ++it) {
+			int line = ax.line(it.row());
+			int q = ax.pos(it.row());
+			for (int t = 0; t <= order; t++) {
+				int p = q - t;
+				if (p >= 0 && p < out_len) {
+					tripletList.push_back(Triplet(ax.index(line, p, out_len), k,
+					                              weights[t] * it.value()));
+				}
+			}
+		}
+	}
+	Matrix coeffs(lin.size[0] * lin.size[1], rh.cols());
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return coeffs;
+}
+
+/**
+ * Maps entry (A, B) of the P x Q constant C, multiplied by entry IDX of the
+ * vectorized M x N argument X, to its row of the vectorized kron(C, X).
+ */
+class KronRow {
+public:
+	KronRow(int m, int n, int p) : m(m), n(n), p(p) {}
+
+	int operator()(int idx, int a, int b) const {
+		int i = idx % m;
+		int j = idx / m;
+		return ((b * n + j) * p + a) * m + i;
+	}
+
+private:
+	int m, n, p;
+};
+
+/**
+ * Return the coefficients for KRON, the Kronecker product kron(C, X) of the
+ * constant C in DATA with the M x N argument X.
+ *
+ * Column J * M + I of the coefficient is a copy of C with its rows spread
+ * out, so it is written directly in compressed column form, in parallel
+ * over the columns.
  *
  * Parameters: linOp LIN with type KRON
  * Returns: vector containing the coefficient matrix for the Kronecker
@@ -357,35 +914,132 @@ int get_id_data(LinOp &lin) {
 std::vector<Matrix> get_kron_mat(LinOp &lin) {
 	assert(lin.type == KRON);
 	Matrix constant = get_constant_data(lin, false);
-	int lh_rows = constant.rows();
-	int lh_cols = constant.cols();
 	int rh_rows =  lin.args[0]->size[0];
 	int rh_cols =  lin.args[0]->size[1];
 
-	int rows = rh_rows * rh_cols * lh_rows * lh_cols;
-	int cols = rh_rows * rh_cols;
-	Matrix coeffs(rows, cols);
+	int rows = rh_rows * rh_cols * constant.rows() * constant.cols();
+	KronRow row_map(rh_rows, rh_cols, constant.rows());
+	Matrix coeffs = spread_coeffs(constant, rh_rows * rh_cols, rows, row_map);
+	return build_vector(coeffs);
+}
 
-	std::vector<Triplet> tripletList;
-	tripletList.reserve(rh_rows * rh_cols * constant.nonZeros());
-	for ( int k = 0; k < constant.outerSize(); ++k ) {
-		for ( Matrix::InnerIterator it(constant, k); it; ++it ) {
-			int row = (rh_rows * rh_cols * (lh_rows * it.col())) + (it.row() * rh_rows);
-			int col = 0;
-			for(int j = 0; j < rh_cols; j++){
-				for(int i = 0; i < rh_rows; i++) {
-					tripletList.push_back(Triplet(row + i, col, it.value()));
-					col++;
-				}
-				row += lh_rows * rh_rows;
-			}
-		}
+/**
+ * Maps entry (A, B) of the P x Q constant C, multiplied by entry IDX of the
+ * vectorized M x N argument X, to its row of the vectorized kron(X, C).
+ */
+class KronRightRow {
+public:
+	KronRightRow(int m, int p, int q) : m(m), p(p), q(q) {}
+
+	int operator()(int idx, int a, int b) const {
+		int i = idx % m;
+		int j = idx / m;
+		return (j * q + b) * (m * p) + i * p + a;
 	}
-	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
-	coeffs.makeCompressed();
+
+private:
+	int m, p, q;
+};
+
+/**
+ * Return the coefficients for KRON_RIGHT, the Kronecker product kron(X, C)
+ * of the M x N argument X with the P x Q constant C in DATA.
+ *
+ * Entry (I, J) of X is multiplied by every entry C(A, B), which lands in
+ * row (J * Q + B) * M * P + I * P + A of the vectorized product. Column
+ * J * M + I of the coefficient is therefore a copy of C with its rows
+ * spread out, already sorted, so the coefficient is written directly in
+ * compressed column form and every column is filled in parallel.
+ *
+ * Parameters: linOp LIN with type KRON_RIGHT
+ * Returns: vector containing the coefficient matrix for the Kronecker
+ * product.
+ */
+std::vector<Matrix> get_kron_right_mat(LinOp &lin) {
+	assert(lin.type == KRON_RIGHT);
+	Matrix constant = get_constant_data(lin, false);
+	int m = lin.args[0]->size[0];
+	int n = lin.args[0]->size[1];
+	KronRightRow row_map(m, constant.rows(), constant.cols());
+	Matrix coeffs = spread_coeffs(constant, m * n, lin.size[0] * lin.size[1],
+	                              row_map);
 	return build_vector(coeffs);
 }
 
+/**
+ * Applies the KRON_RIGHT coefficient to RH by spreading every entry of RH
+ * over the nonzeros of the constant, without forming the coefficient.
+ *
+ * Parameters: linOp LIN with type KRON_RIGHT, sparse matrix RH
+ * Returns: the product of the KRON_RIGHT coefficient and RH
+ */
+Matrix apply_kron_right(LinOp &lin, Matrix &rh) {
+	assert(lin.type == KRON_RIGHT);
+	Matrix constant = get_constant_data(lin, false);
+	KronRightRow row_map(lin.args[0]->size[0], constant.rows(), constant.cols());
+	return spread_rows(rh, constant, lin.size[0] * lin.size[1], row_map);
+}
+
+/**
+ * Maps entry (A, B) of the kernel K, multiplied by entry IDX of the
+ * vectorized M x N argument X, to its row of the vectorized full 2-D
+ * convolution, which has OUT_ROWS = M + K.rows() - 1 rows.
+ */
+class Conv2DRow {
+public:
+	Conv2DRow(int m, int out_rows) : m(m), out_rows(out_rows) {}
+
+	int operator()(int idx, int a, int b) const {
+		int i = idx % m;
+		int j = idx / m;
+		return (j + b) * out_rows + i + a;
+	}
+
+private:
+	int m, out_rows;
+};
+
+/**
+ * Return the coefficients for CONV2D, the full 2-D convolution of the
+ * M x N argument X with the kernel K in DATA:
+ *
+ * 		Y(R, C) = sum_{A, B} K(A, B) X(R - A, C - B),
+ *
+ * of size (M + K.rows() - 1) x (N + K.cols() - 1). The coefficient is
+ * doubly block Toeplitz: column J * M + I is a copy of K shifted down by
+ * I rows and right by J columns of Y. It is written directly in compressed
+ * column form, in parallel over the entries of X.
+ *
+ * Parameters: linOp LIN with type CONV2D. Data should contain the kernel.
+ *
+ * Returns: vector of coefficients for 2-D convolution linOp
+ */
+std::vector<Matrix> get_conv2d_mat(LinOp &lin) {
+	assert(lin.type == CONV2D);
+	Matrix constant = get_constant_data(lin, false);
+	int m = lin.args[0]->size[0];
+	int n = lin.args[0]->size[1];
+	Conv2DRow row_map(m, lin.size[0]);
+	Matrix toeplitz = spread_coeffs(constant, m * n, lin.size[0] * lin.size[1],
+	                                row_map);
+	return build_vector(toeplitz);
+}
+
+/**
+ * Applies the CONV2D coefficient to RH by convolving every column of RH,
+ * read as an M x N image, with the kernel without forming the doubly block
+ * Toeplitz matrix.
+ *
+ * Parameters: linOp LIN with type CONV2D, sparse matrix RH
+ * Returns: the product of the CONV2D coefficient and RH
+ */
+Matrix apply_conv2d(LinOp &lin, Matrix &rh) {
+	assert(lin.type == CONV2D);
+	Matrix constant = get_constant_data(lin, false);
+	Conv2DRow row_map(lin.args[0]->size[0], lin.size[0]);
+	return spread_rows(rh, constant, lin.size[0] * lin.size[1], row_map);
+}
+
 /**
  * Return the coefficients for VSTACK.
  *
@@ -423,24 +1077,11 @@ std::vector<Matrix> get_conv_mat(LinOp &lin) {
 	assert(lin.type == CONV);
 	Matrix constant = get_constant_data(lin, false);
 	int rows = lin.size[0];
-	int nonzeros = constant.rows();
 	int cols = lin.args[0]->size[0];
 
-	Matrix toeplitz(rows, cols);
-
-	std::vector<Triplet> tripletList;
-	tripletList.reserve(nonzeros * cols);
-	for (int col = 0; col < cols; col++) {
-		int row_start = col;
-		for ( int k = 0; k < constant.outerSize(); ++k ) {
-			for ( Matrix::InnerIterator it(constant, k); it; ++it ) {
-				int row_idx = row_start + it.row();
-				tripletList.push_back(Triplet(row_idx, col, it.value()));
-			}
-		}
-	}
-	toeplitz.setFromTriplets(tripletList.begin(), tripletList.end());
-	toeplitz.makeCompressed();
+	/* Column COL holds the kernel shifted down by COL rows */
+	Matrix toeplitz = spread_coeffs(constant, cols, rows,
+	                                [](int col, int a, int) { return col + a; });
 	return build_vector(toeplitz);
 }
 
@@ -637,10 +1278,67 @@ std::vector<Matrix> get_index_mat(LinOp &lin) {
 	return build_vector(coeffs);
 }
 
+/**
+ * Looks up the MUL_ELEM constant for each entry of the argument, applying
+ * broadcasting without materializing a full-size constant.
+ *
+ * A constant with as many entries as the argument is read in column major
+ * order, as before. Otherwise a 1 x 1 constant applies to every entry, a
+ * 1 x COLS row to every row and a ROWS x 1 column to every column.
+ * The constant is read in place from LIN, without a copy.
+ */
+class ElemwiseConstant {
+public:
+	ElemwiseConstant(LinOp &lin) : lin(lin), sparse(lin.sparse_data) {
+		assert(lin.type == MUL_ELEM);
+		arg_rows = lin.args[0]->size[0];
+		int arg_cols = lin.args[0]->size[1];
+		if (lin.sparse) {
+			rows = sparse.rows();
+			cols = sparse.cols();
+		} else {
+			rows = lin.dense_data.rows();
+			cols = lin.dense_data.cols();
+		}
+		full = (long) rows * cols == (long) arg_rows * arg_cols;
+		if (!full && !((rows == 1 || rows == arg_rows) &&
+		               (cols == 1 || cols == arg_cols))) {
+			std::cerr << "Error: MUL_ELEM constant of size " << rows << " x "
+			          << cols << " does not broadcast to " << arg_rows << " x "
+			          << arg_cols << "." << std::endl;
+			exit(-1);
+		}
+	}
+
+	/* Constant multiplying entry IDX of the vectorized argument */
+	double value(int idx) const {
+		int i, j;
+		if (full) {
+			i = idx % rows;
+			j = idx / rows;
+		} else {
+			i = (rows == 1) ? 0 : idx % arg_rows;
+			j = (cols == 1) ? 0 : idx / arg_rows;
+		}
+		if (lin.sparse) {
+			return sparse.coeff(i, j);
+		}
+		return lin.dense_data(i, j);
+	}
+
+private:
+	const LinOp &lin;
+	const Matrix &sparse;
+	int rows;
+	int cols;
+	int arg_rows;
+	bool full;
+};
+
 /**
  * Return the coefficients for MUL_ELEM: an N x N diagonal matrix where the
- * n-th element on the diagonal corresponds to the element n = j*rows + i in
- * the data matrix CONSTANT.
+ * n-th element on the diagonal is the constant for element n = j*rows + i
+ * of the argument, with the broadcasting rules of ElemwiseConstant.
  *
  * Parameters: linOp of type MUL_ELEM
  *
@@ -649,15 +1347,16 @@ std::vector<Matrix> get_index_mat(LinOp &lin) {
  */
 std::vector<Matrix> get_mul_elemwise_mat(LinOp &lin) {
 	assert(lin.type == MUL_ELEM);
-	Matrix constant = get_constant_data(lin, true);
-	int n = constant.rows();
+	ElemwiseConstant constant(lin);
+	int n = lin.args[0]->size[0] * lin.args[0]->size[1];
 
 	// build a giant diagonal matrix
 	std::vector<Triplet> tripletList;
 	tripletList.reserve(n);
-	for ( int k = 0; k < constant.outerSize(); ++k ) {
-		for ( Matrix::InnerIterator it(constant, k); it; ++it ) {
-			tripletList.push_back(Triplet(it.row(), it.row(), it.value()));
+	for (int i = 0; i < n; i++) {
+		double val = constant.value(i);
+		if (val != 0) {
+			tripletList.push_back(Triplet(i, i, val));
 		}
 	}
 	Matrix coeffs(n, n);
@@ -666,6 +1365,27 @@ std::vector<Matrix> get_mul_elemwise_mat(LinOp &lin) {
 	return build_vector(coeffs);
 }
 
+/**
+ * Applies the MUL_ELEM coefficient to RH by scaling each of its rows by the
+ * matching (broadcast) constant, in O(nnz(RH)).
+ *
+ * Parameters: linOp LIN with type MUL_ELEM, sparse matrix RH
+ * Returns: the product of the MUL_ELEM coefficient and RH
+ */
+Matrix apply_mul_elemwise(LinOp &lin, Matrix &rh) {
+	assert(lin.type == MUL_ELEM);
+	ElemwiseConstant constant(lin);
+	Matrix coeffs = rh;
+	for (int k = 0; k < coeffs.outerSize(); ++k) {
+		for (Matrix::InnerIterator it(coeffs, k); it; ++it) {
+			it.valueRef() *= constant.value(it.row());
+		}
+	}
+	coeffs.prune(0.0);
+	coeffs.makeCompressed();
+	return coeffs;
+}
+
 /**
  * Return the coefficients for RMUL (right multiplication): a ROWS * N
  * by COLS * N matrix given by the kronecker product between the
@@ -683,25 +1403,164 @@ std::vector<Matrix> get_rmul_mat(LinOp &lin) {
 	int cols = constant.cols();
 	int n = lin.size[0];
 
-	Matrix coeffs(cols * n, rows * n);
+	/* Each element (R, C) of CONSTANT occupies the diagonal of an N x N block
+		 in the matrix, so column R * N + I holds row R of CONSTANT with entry C
+		 in row C * N + I. */
+	Matrix transposed = constant.transpose();
+	Matrix coeffs = copy_columns(transposed, cols * n, rows * n,
+	                             [n](int k) { return k / n; },
+	                             [n](int k, int c) { return c * n + k % n; });
+	return build_vector(coeffs);
+}
+
+/**
+ * Returns the position of entry (I, J), I >= J, of an N x N matrix in the
+ * column major vectorization of its lower triangle.
+ */
+long lower_tri_index(int i, int j, int n) {
+	return (long) j * n - (long) j * (j - 1) / 2 + (i - j);
+}
+
+/**
+ * Computes where entry IDX of a vectorized N x N matrix goes under SVEC:
+ * sets OUT_ROW to its lower triangular position and WEIGHT to 1 on the
+ * diagonal and 1 / sqrt(2) off the diagonal.
+ */
+void get_svec_entry(int idx, int n, long &out_row, double &weight) {
+	int i = idx % n;
+	int j = idx / n;
+	if (i < j) {
+		std::swap(i, j);
+	}
+	out_row = lower_tri_index(i, j, n);
+	weight = (i == j) ? 1.0 : 1.0 / std::sqrt(2.0);
+}
+
+/**
+ * Return the coefficients for SVEC: the N(N+1)/2 x N^2 matrix mapping an
+ * N x N matrix X to its scaled lower triangular vectorization in the
+ * layout used by SCS, column by column:
+ *
+ * 		(X_00, sqrt(2) X_10, ..., sqrt(2) X_(N-1)0, X_11, sqrt(2) X_21, ...).
+ *
+ * Off-diagonal entries are taken as sqrt(2) (X_ij + X_ji) / 2, which equals
+ * sqrt(2) X_ij for symmetric X, so the argument needs no explicit
+ * symmetrization.
+ *
+ * Parameters: linOp with type SVEC
+ *
+ * Returns: vector containing coefficient matrix COEFFS
+ */
+std::vector<Matrix> get_svec_mat(LinOp &lin) {
+	assert(lin.type == SVEC);
+	int n = lin.args[0]->size[0];
+	assert(n == lin.args[0]->size[1]);
+
+	Matrix coeffs(lin.size[0] * lin.size[1], n * n);
 	std::vector<Triplet> tripletList;
-	tripletList.reserve(n * constant.nonZeros());
-	for ( int k = 0; k < constant.outerSize(); ++k ) {
-		for ( Matrix::InnerIterator it(constant, k); it; ++it ) {
-			double val = it.value();
-
-			// each element of CONSTANT occupies an N x N block in the matrix
-			int row_start = it.col() * n;
-			int col_start = it.row() * n;
-			for (int i = 0; i < n; i++) {
-				int row_idx = row_start + i;
-				int col_idx = col_start + i;
-				tripletList.push_back(Triplet(row_idx, col_idx, val));
-			}
+	tripletList.reserve(n * n);
+	for (int idx = 0; idx < n * n; idx++) {
+		long row;
+		double weight;
+		get_svec_entry(idx, n, row, weight);
+		tripletList.push_back(Triplet(row, idx, weight));
+	}
+	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
+	coeffs.makeCompressed();
+	return build_vector(coeffs);
+}
+
+/**
+ * Applies the SVEC coefficient to RH by folding each row of RH onto its
+ * lower triangular position, in O(nnz(RH)).
+ *
+ * Parameters: linOp LIN with type SVEC, sparse matrix RH
+ * Returns: the product of the SVEC coefficient and RH
+ */
+Matrix apply_svec(LinOp &lin, Matrix &rh) {
+	assert(lin.type == SVEC);
+	int n = lin.args[0]->size[0];
+
+	std::vector<Triplet> tripletList;
+	tripletList.reserve(rh.nonZeros());
+	for (int k = 0; k < rh.outerSize(); ++k) {
+		for (Matrix::InnerIterator it(rh, k); it; ++it) {
+			long row;
+			double weight;
+			get_svec_entry(it.row(), n, row, weight);
+			tripletList.push_back(Triplet(row, k, weight * it.value()));
 		}
 	}
+	Matrix coeffs(lin.size[0] * lin.size[1], rh.cols());
 	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
 	coeffs.makeCompressed();
+	return coeffs;
+}
+
+/**
+ * Return the coefficients for BLOCK_DIAG_MUL: the argument X = [X_1 ... X_K]
+ * is split into K column blocks of equal width W, and block I is multiplied
+ * by the constant B_I, giving [B_1 X_1 ... B_K X_K]. The constants are
+ * stored side by side in the data matrix [B_1 ... B_K], so K is the number
+ * of data columns divided by the number of argument rows.
+ *
+ * The coefficient is block diagonal with one copy of B_I for every column
+ * of X_I. It is written directly in compressed column form: column
+ * COL * Q + S of the coefficient holds column S of B_I, shifted to rows
+ * COL * P onwards, so every column can be filled independently and in
+ * parallel.
+ *
+ * Parameters: linOp with type BLOCK_DIAG_MUL
+ *
+ * Returns: vector containing coefficient matrix COEFFS
+ */
+std::vector<Matrix> get_block_diag_mul_mat(LinOp &lin) {
+	assert(lin.type == BLOCK_DIAG_MUL);
+	Matrix blocks = get_constant_data(lin, false);
+	int q = lin.args[0]->size[0];
+	int arg_cols = lin.args[0]->size[1];
+	int p = blocks.rows();
+	if (q == 0 || blocks.cols() % q != 0 || blocks.cols() == 0 ||
+	    arg_cols % (blocks.cols() / q) != 0) {
+		std::cerr << "Error: BLOCK_DIAG_MUL blocks do not match the argument."
+		          << std::endl;
+		exit(-1);
+	}
+	int num_blocks = blocks.cols() / q;
+	int width = arg_cols / num_blocks;
+
+	/* Coefficient column COL * Q + S copies data column I * Q + S */
+	int num_coeff_cols = arg_cols * q;
+	Matrix coeffs(lin.size[0] * lin.size[1], num_coeff_cols);
+	int *outer = coeffs.outerIndexPtr();
+	outer[0] = 0;
+	for (int col = 0; col < arg_cols; col++) {
+		int block = col / width;
+		for (int s = 0; s < q; s++) {
+			int data_col = block * q + s;
+			int nnz = blocks.outerIndexPtr()[data_col + 1] -
+			          blocks.outerIndexPtr()[data_col];
+			outer[col * q + s + 1] = outer[col * q + s] + nnz;
+		}
+	}
+	coeffs.resizeNonZeros(outer[num_coeff_cols]);
+
+	int *inner = coeffs.innerIndexPtr();
+	double *values = coeffs.valuePtr();
+	int num_chunks = get_num_chunks(outer[num_coeff_cols]);
+	parallel_chunks(arg_cols, num_chunks, [&](int, long begin, long end) {
+		for (long col = begin; col < end; col++) {
+			int block = col / width;
+			for (int s = 0; s < q; s++) {
+				int dest = outer[col * q + s];
+				for (Matrix::InnerIterator it(blocks, block * q + s); it; ++it) {
+					inner[dest] = col * p + it.row();
+					values[dest] = it.value();
+					dest++;
+				}
+			}
+		}
+	});
 	return build_vector(coeffs);
 }
 
@@ -727,22 +1586,15 @@ std::vector<Matrix> get_mul_mat(LinOp &lin) {
 	}
 
 	int num_blocks = lin.size[1];
-	Matrix coeffs (num_blocks * block_rows, num_blocks * block_cols);
 
-	std::vector<Triplet> tripletList;
-	tripletList.reserve(num_blocks * block.nonZeros());
-	for (int curr_block = 0; curr_block < num_blocks; curr_block++) {
-		int start_i = curr_block * block_rows;
-		int start_j = curr_block * block_cols;
-		for ( int k = 0; k < block.outerSize(); ++k ) {
-			for ( Matrix::InnerIterator it(block, k); it; ++it ) {
-				tripletList.push_back(Triplet(start_i + it.row(), start_j + it.col(),
-				                              it.value()));
-			}
-		}
-	}
-	coeffs.setFromTriplets(tripletList.begin(), tripletList.end());
-	coeffs.makeCompressed();
+	/* Column B * BLOCK_COLS + S holds column S of BLOCK, shifted down to the
+		 rows of block B */
+	Matrix coeffs = copy_columns(block, num_blocks * block_rows,
+	                             num_blocks * block_cols,
+	                             [block_cols](int k) { return k % block_cols; },
+	                             [block_rows, block_cols](int k, int r) {
+		return (k / block_cols) * block_rows + r;
+	});
 	return build_vector(coeffs);
 }
 
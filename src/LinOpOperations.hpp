@@ -25,4 +25,15 @@ std::map<int, Matrix> get_variable_coeffs(LinOp &lin);
 std::map<int, Matrix> get_const_coeffs(LinOp &lin);
 std::vector<Matrix> get_func_coeffs(LinOp& lin);
 
+/* Fast path for linOps whose coefficient is a cheap function of the rows of
+   its argument's coefficient: APPLY_FUNC_COEFF returns the same product as
+   multiplying the coefficient of argument ARG_IDX with RH, without forming
+   the coefficient. */
+bool has_func_apply(LinOp &lin);
+Matrix apply_func_coeff(LinOp &lin, int arg_idx, Matrix &rh);
+
+/* Returns the symmetric part (Q + Q^T) / 2 of the constant Q of a QUAD_FORM
+   linOp, which has one row and column per entry of its argument. */
+Matrix get_quad_form_mat(LinOp &lin);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "MemoryResource.hpp"
+#include "ExecutionContext.hpp"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+/* Modes of the mbind system call, from linux/mempolicy.h */
+static const int MPOL_PREFERRED_MODE = 1;
+static const int MPOL_INTERLEAVE_MODE = 3;
+
+/* Size of a transparent huge page on x86-64 and the usual arm64 setup */
+static const size_t HUGE_PAGE_SIZE = 1 << 21;
+
+/* Applies the NUMA policy MODE over NODES to [PTR, PTR + BYTES). Like the
+	 huge page advice, this is a hint: it is skipped on machines with one
+	 node and failures are ignored. */
+static void bind_pages(void *ptr, size_t bytes, int mode,
+                       const std::vector<int> &nodes) {
+	const int bits = 8 * sizeof(unsigned long);
+	const int max_nodes = 1024;
+	unsigned long mask[max_nodes / bits] = {0};
+	int count = 0;
+	for (unsigned i = 0; i < nodes.size(); i++) {
+		if (nodes[i] >= 0 && nodes[i] < max_nodes) {
+			mask[nodes[i] / bits] |= 1UL << (nodes[i] % bits);
+			count++;
+		}
+	}
+	if (count == 0 || (mode == MPOL_INTERLEAVE_MODE && count == 1)) {
+		return;
+	}
+	syscall(SYS_mbind, ptr, bytes, mode, mask, max_nodes + 1, 0);
+}
+#endif
+
+PageResource::PageResource(int policy, bool huge_pages, int node)
+	: policy(policy), huge_pages(huge_pages), node(node) {}
+
+#ifdef __linux__
+/* Bytes mapped for a buffer of BYTES bytes: whole pages, or whole huge
+	 pages if HUGE_PAGES is set */
+static size_t mapped_size(size_t bytes, bool huge_pages) {
+	size_t page = huge_pages ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+	return (bytes + page - 1) / page * page;
+}
+
+void *PageResource::allocate(size_t bytes) {
+	if (bytes < PAGE_RESOURCE_MIN_BYTES) {
+		return ::operator new(bytes);
+	}
+	size_t size = mapped_size(bytes, huge_pages);
+
+	/* Huge pages need a huge page aligned range: map one more huge page
+		 and unmap the unaligned ends */
+	size_t slack = huge_pages ? HUGE_PAGE_SIZE : 0;
+	void *map = mmap(NULL, size + slack, PROT_READ | PROT_WRITE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+	char *start = static_cast<char*>(map);
+	if (huge_pages) {
+		size_t address = reinterpret_cast<size_t>(map);
+		char *aligned = start + (HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE) %
+		                        HUGE_PAGE_SIZE;
+		if (aligned > start) {
+			munmap(start, aligned - start);
+		}
+		if (aligned + size < start + size + slack) {
+			munmap(aligned + size, start + size + slack - (aligned + size));
+		}
+		start = aligned;
+		madvise(start, size, MADV_HUGEPAGE);
+	}
+
+	/* The policies take effect when the pages are first written */
+	if (policy == MEMORY_INTERLEAVE) {
+		bind_pages(start, size, MPOL_INTERLEAVE_MODE, get_memory_nodes());
+	} else if (policy == MEMORY_NODE) {
+		bind_pages(start, size, MPOL_PREFERRED_MODE, std::vector<int>(1, node));
+	} else if (policy == MEMORY_FIRST_TOUCH) {
+		/* Part K of the buffer goes to the K-th node */
+		std::vector<int> nodes = get_memory_nodes();
+		size_t page = huge_pages ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+		size_t num_pages = size / page;
+		for (unsigned k = 0; nodes.size() > 1 && k < nodes.size(); k++) {
+			size_t begin = num_pages * k / nodes.size();
+			size_t end = num_pages * (k + 1) / nodes.size();
+			if (end > begin) {
+				bind_pages(start + begin * page, (end - begin) * page,
+				           MPOL_PREFERRED_MODE, std::vector<int>(1, nodes[k]));
+			}
+		}
+	}
+	return start;
+}
+
+void PageResource::deallocate(void *ptr, size_t bytes) {
+	if (bytes < PAGE_RESOURCE_MIN_BYTES) {
+		::operator delete(ptr);
+		return;
+	}
+	munmap(ptr, mapped_size(bytes, huge_pages));
+}
+#else
+void *PageResource::allocate(size_t bytes) {
+	return ::operator new(bytes);
+}
+
+void PageResource::deallocate(void *ptr, size_t) {
+	::operator delete(ptr);
+}
+#endif
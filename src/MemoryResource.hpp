@@ -0,0 +1,157 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Pluggable allocation of the large output buffers.
+
+#ifndef MEMORYRESOURCE_H
+#define MEMORYRESOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/* Source of the memory behind the V, I and J arrays of ProblemData. This
+ * has the shape of std::pmr::memory_resource, which needs C++17. */
+class MemoryResource {
+public:
+	virtual ~MemoryResource() {}
+
+	/* Returns BYTES bytes aligned for any scalar type */
+	virtual void *allocate(size_t bytes) = 0;
+
+	/* Frees PTR, which was returned by allocate(BYTES) */
+	virtual void deallocate(void *ptr, size_t bytes) = 0;
+};
+
+/* Allocates with the global operator new */
+class NewDeleteResource : public MemoryResource {
+public:
+	void *allocate(size_t bytes) {
+		return ::operator new(bytes);
+	}
+
+	void deallocate(void *ptr, size_t) {
+		::operator delete(ptr);
+	}
+};
+
+/* Buffers smaller than this come from operator new in PageResource */
+static const size_t PAGE_RESOURCE_MIN_BYTES = 1 << 21;
+
+/* Maps large buffers directly from the kernel, so that their pages can be
+ * placed by POLICY, a MemoryPolicy from ExecutionContext.hpp, and, if
+ * HUGE_PAGES is set, backed by
+ * transparent huge pages, which saves TLB misses on multi-GB arrays.
+ * NODE is the node of MEMORY_NODE. On other systems than Linux this is the
+ * same as NewDeleteResource. */
+class PageResource : public MemoryResource {
+public:
+	PageResource(int policy, bool huge_pages, int node);
+
+	void *allocate(size_t bytes);
+	void deallocate(void *ptr, size_t bytes);
+
+private:
+	int policy;
+	bool huge_pages;
+	int node;
+};
+
+/* Returns the resource used when no other one is selected */
+inline std::shared_ptr<MemoryResource> new_delete_resource() {
+	static std::shared_ptr<MemoryResource> resource(new NewDeleteResource());
+	return resource;
+}
+
+/* Resource of the buffers created on this thread, set by ContextScope in
+ * ExecutionContext.hpp. Empty selects new_delete_resource(). */
+inline std::shared_ptr<MemoryResource> &current_resource() {
+	static thread_local std::shared_ptr<MemoryResource> resource;
+	return resource;
+}
+
+/* Makes RESOURCE the current resource of this thread while in scope. An
+ * empty RESOURCE changes nothing. */
+class ResourceScope {
+public:
+	ResourceScope(const std::shared_ptr<MemoryResource> &resource)
+		: outer(current_resource()), active(resource != NULL) {
+		if (active) {
+			current_resource() = resource;
+		}
+	}
+
+	~ResourceScope() {
+		if (active) {
+			current_resource() = outer;
+		}
+	}
+
+private:
+	std::shared_ptr<MemoryResource> outer;
+	bool active;
+};
+
+/* Allocator that takes its memory from a MemoryResource. A default
+ * constructed allocator uses the current resource of the thread that
+ * creates it, and keeps that resource alive for as long as it is used. */
+template <typename T>
+class ResourceAllocator {
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	std::shared_ptr<MemoryResource> resource;
+
+	ResourceAllocator() : resource(current_resource()) {
+		if (!resource) {
+			resource = new_delete_resource();
+		}
+	}
+
+	explicit ResourceAllocator(const std::shared_ptr<MemoryResource> &resource)
+		: resource(resource) {}
+
+	template <typename U>
+	ResourceAllocator(const ResourceAllocator<U> &other)
+		: resource(other.resource) {}
+
+	T *allocate(size_t n) {
+		return static_cast<T*>(resource->allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T *ptr, size_t n) {
+		resource->deallocate(ptr, n * sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) {
+	return a.resource == b.resource;
+}
+
+template <typename T, typename U>
+bool operator!=(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) {
+	return a.resource != b.resource;
+}
+
+/* Vector whose memory comes from a MemoryResource */
+template <typename T>
+using Buffer = std::vector<T, ResourceAllocator<T> >;
+
+#endif
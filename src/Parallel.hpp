@@ -0,0 +1,190 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Helpers for splitting loops across threads.
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ThreadPool.hpp"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/* Loops shorter than this run on the calling thread only */
+static const long PARALLEL_MIN_WORK = 1 << 15;
+
+/* Returns the number of CPUs the process may run on. On Linux this honours
+ * the affinity mask, so runs under taskset or a cgroup cpuset do not start
+ * more threads than they have cores. */
+inline int count_cpus() {
+#ifdef __linux__
+	cpu_set_t cpus;
+	if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0 && CPU_COUNT(&cpus) > 0) {
+		return CPU_COUNT(&cpus);
+	}
+#endif
+	int n = std::thread::hardware_concurrency();
+	return n > 0 ? n : 1;
+}
+
+/* Returns the number of threads used by the parallel loops: the size of
+ * the current pool, if there is one, or the number of CPUs */
+inline int get_num_threads() {
+	if (current_pool() != NULL) {
+		return current_pool()->size();
+	}
+	static int n = count_cpus();
+	return n;
+}
+
+/* Pool of one thread per CPU, used by the parallel loops on threads
+ * without a current pool. It is started by the first loop that needs it
+ * and never deleted, so no worker is joined during static destruction. */
+inline ThreadPool *shared_pool() {
+	static ThreadPool *pool = new ThreadPool(count_cpus(), std::vector<int>(),
+	                                         false);
+	return pool;
+}
+
+/* Returns the pool that runs the parallel loops on this thread */
+inline ThreadPool *loop_pool() {
+	return current_pool() != NULL ? current_pool() : shared_pool();
+}
+
+/* True on threads that are running part of a parallel loop or task set.
+ * Parallel loops nested inside one run serially, so nested parallelism never
+ * oversubscribes the machine. */
+inline bool &in_parallel_region() {
+	static thread_local bool flag = false;
+	return flag;
+}
+
+/* Marks the current thread as busy in a parallel region while in scope */
+class ParallelRegion {
+public:
+	ParallelRegion() : outer(in_parallel_region()) {
+		in_parallel_region() = true;
+	}
+	~ParallelRegion() {
+		in_parallel_region() = outer;
+	}
+
+private:
+	bool outer;
+};
+
+/* Returns the number of chunks [0, N) is split into by PARALLEL_CHUNKS */
+inline int get_num_chunks(long n) {
+	if (n < PARALLEL_MIN_WORK || in_parallel_region()) {
+		return 1;
+	}
+	return (int) std::min<long>(get_num_threads(), n / (PARALLEL_MIN_WORK / 2));
+}
+
+template <typename Function>
+void parallel_tasks(long num_tasks, Function fn);
+
+/**
+ * Splits [0, N) into NUM_CHUNKS contiguous chunks and calls
+ * FN(chunk, begin, end) for each of them. Chunk boundaries depend only on
+ * N and NUM_CHUNKS, so results that are written by chunk are deterministic.
+ *
+ * The chunks are run as a task set by PARALLEL_TASKS, so they take only the
+ * spare threads of the pool and run serially when none are free.
+ */
+template <typename Function>
+void parallel_chunks(long n, int num_chunks, Function fn) {
+	num_chunks = std::max(1, num_chunks);
+	if (num_chunks == 1) {
+		fn(0, 0L, n);
+		return;
+	}
+	parallel_tasks(num_chunks, [&fn, n, num_chunks](long chunk) {
+		fn((int) chunk, n * chunk / num_chunks, n * (chunk + 1) / num_chunks);
+	});
+}
+
+/**
+ * Calls FN(begin, end) on disjoint ranges covering [0, N), in parallel when
+ * N is large enough to be worth it.
+ */
+template <typename Function>
+void parallel_for(long n, Function fn) {
+	parallel_chunks(n, get_num_chunks(n), [&fn](int, long begin, long end) {
+		fn(begin, end);
+	});
+}
+
+/* Number of workers of the loop pool, beyond the ones already busy, that
+ * PARALLEL_TASKS may still use. Shared by nested task sets so that together
+ * they never use more than get_num_threads() threads. */
+inline std::atomic<int> &spare_threads() {
+	return loop_pool()->spare;
+}
+
+/* Takes up to WANT spare threads and returns how many were taken */
+inline int reserve_threads(int want) {
+	int available = spare_threads().load();
+	while (available > 0 && want > 0) {
+		int take = std::min(available, want);
+		if (spare_threads().compare_exchange_weak(available, available - take)) {
+			return take;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Calls FN(task) once for every task in [0, NUM_TASKS). The calling thread
+ * works on the tasks together with as many spare threads as are free, so
+ * task sets nested inside a task run in parallel while threads are idle and
+ * serially otherwise. Tasks are claimed one at a time from a shared counter,
+ * so threads that finish cheap tasks early take over the remaining ones and
+ * uneven tasks stay balanced. Only the assignment of tasks to threads varies
+ * between runs; callers that write each task's result to its own slot get
+ * deterministic results.
+ *
+ * Loops in PARALLEL_CHUNKS called from a task run serially. The other
+ * threads are the workers of the current pool, or of the shared pool if
+ * there is none.
+ */
+template <typename Function>
+void parallel_tasks(long num_tasks, Function fn) {
+	int num_extra = 0;
+	if (num_tasks > 1) {
+		num_extra = reserve_threads(
+			(int) std::min<long>(get_num_threads(), num_tasks) - 1);
+	}
+	std::atomic<long> next(0);
+	auto worker = [&fn, &next, num_tasks]() {
+		ParallelRegion region;
+		for (long task = next++; task < num_tasks; task = next++) {
+			fn(task);
+		}
+	};
+	if (num_extra > 0) {
+		loop_pool()->run(num_extra, worker);
+	} else {
+		worker();
+	}
+	spare_threads() += num_extra;
+}
+
+#endif
@@ -0,0 +1,646 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Presolve.hpp"
+#include "ProblemDataOperations.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+/**
+ * Working state of the presolve loop. Entries are addressed by their index
+ * in V, I, J, which are sorted by column after canonicalize, so the entries
+ * of column j are COL_START[j] ... COL_START[j + 1] - 1. ROW_ENTRIES lists
+ * the entries of each row in the same way.
+ */
+class PresolveState {
+public:
+	int num_rows;
+	int num_cols;
+	int num_reducible;
+
+	std::vector<double> vals;
+	std::vector<int> rows;
+	std::vector<int> cols;
+	std::vector<double> const_vec;
+
+	std::vector<long> col_start;
+	std::vector<long> row_start;
+	std::vector<long> row_entries;
+
+	std::vector<bool> entry_alive;
+	std::vector<bool> row_alive;
+	std::vector<bool> col_alive;
+	std::vector<int> row_count;
+	std::vector<int> col_count;
+
+	std::vector<double> lb;
+	std::vector<double> ub;
+	std::vector<double> value;
+
+	/* Rows whose count dropped to one or zero and need another look */
+	std::vector<int> queue;
+
+	void remove_entry(long k) {
+		entry_alive[k] = false;
+		row_count[rows[k]]--;
+		col_count[cols[k]]--;
+		if (rows[k] < num_reducible && row_alive[rows[k]] &&
+		    row_count[rows[k]] <= 1) {
+			queue.push_back(rows[k]);
+		}
+	}
+
+	/* Returns the only live entry of ROW */
+	long singleton_entry(int row) {
+		for (long p = row_start[row]; p < row_start[row + 1]; p++) {
+			if (entry_alive[row_entries[p]]) {
+				return row_entries[p];
+			}
+		}
+		std::cerr << "Error: presolve row has no live entry" << std::endl;
+		exit(-1);
+	}
+
+	/* Fixes column COL to VAL and moves its entries into the constants */
+	void fix_column(int col, double val) {
+		value[col] = val;
+		col_alive[col] = false;
+		for (long k = col_start[col]; k < col_start[col + 1]; k++) {
+			if (entry_alive[k]) {
+				const_vec[rows[k]] += vals[k] * val;
+				remove_entry(k);
+			}
+		}
+	}
+};
+
+/**
+ * Processes one row that has at most one live entry. Returns false if the
+ * row shows the problem is infeasible.
+ */
+static bool reduce_row(PresolveState &s, int row, int num_zero_rows,
+                       double tol) {
+	bool equality = row < num_zero_rows;
+	double b = s.const_vec[row];
+	if (s.row_count[row] == 0) {
+		s.row_alive[row] = false;
+		return equality ? std::fabs(b) <= tol : b <= tol;
+	}
+
+	long k = s.singleton_entry(row);
+	int col = s.cols[k];
+	double a = s.vals[k];
+	double bound = -b / a;
+	s.row_alive[row] = false;
+	s.remove_entry(k);
+	if (equality) {
+		if (bound < s.lb[col] - tol || bound > s.ub[col] + tol) {
+			return false;
+		}
+		s.fix_column(col, bound);
+		return true;
+	}
+
+	if (a > 0) {
+		s.ub[col] = std::min(s.ub[col], bound);
+	} else {
+		s.lb[col] = std::max(s.lb[col], bound);
+	}
+	if (s.lb[col] > s.ub[col] + tol) {
+		return false;
+	}
+	if (s.ub[col] - s.lb[col] <= tol) {
+		s.fix_column(col, (s.lb[col] + s.ub[col]) / 2);
+	}
+	return true;
+}
+
+/**
+ * Returns the value given to an empty, unfixed column: zero moved into its
+ * bounds.
+ */
+static double free_column_value(double lb, double ub) {
+	if (lb > 0) {
+		return lb;
+	}
+	if (ub < 0) {
+		return ub;
+	}
+	return 0;
+}
+
+/**
+ * Implementation of presolve for either precision. Works in double
+ * precision and writes the reduced problem back to DATA.
+ */
+template <typename Scalar>
+static PresolveInfo presolve_t(ProblemDataT<Scalar> &data, int num_zero_rows,
+                               int num_nonneg_rows, int num_cols, double tol) {
+	data.densify_const_vec();
+	int num_rows = data.const_vec.size();
+	if (num_zero_rows < 0 || num_nonneg_rows < 0 ||
+	    num_zero_rows + num_nonneg_rows > num_rows) {
+		std::cerr << "Error: presolve row sections exceed the number of rows"
+		          << std::endl;
+		exit(-1);
+	}
+
+	canonicalize(data, 0);
+	long nnz = data.V.size();
+	if (nnz > 0) {
+		num_cols = std::max(num_cols, data.J[nnz - 1] + 1);
+	}
+	num_cols = std::max(num_cols, (int) data.obj_vec.size());
+	std::vector<double> obj_vec(data.obj_vec.begin(), data.obj_vec.end());
+	obj_vec.resize(num_cols, 0);
+
+	PresolveState s;
+	s.num_rows = num_rows;
+	s.num_cols = num_cols;
+	s.num_reducible = num_zero_rows + num_nonneg_rows;
+	s.vals.assign(data.V.begin(), data.V.end());
+	s.rows.assign(data.I.begin(), data.I.end());
+	s.cols.assign(data.J.begin(), data.J.end());
+	s.const_vec.assign(data.const_vec.begin(), data.const_vec.end());
+
+	s.col_start.assign(num_cols + 1, 0);
+	s.row_start.assign(num_rows + 1, 0);
+	s.row_count.assign(num_rows, 0);
+	s.col_count.assign(num_cols, 0);
+	for (long k = 0; k < nnz; k++) {
+		s.row_count[s.rows[k]]++;
+		s.col_count[s.cols[k]]++;
+	}
+	for (int j = 0; j < num_cols; j++) {
+		s.col_start[j + 1] = s.col_start[j] + s.col_count[j];
+	}
+	for (int i = 0; i < num_rows; i++) {
+		s.row_start[i + 1] = s.row_start[i] + s.row_count[i];
+	}
+	s.row_entries.resize(nnz);
+	std::vector<long> next(s.row_start.begin(), s.row_start.end() - 1);
+	for (long k = 0; k < nnz; k++) {
+		s.row_entries[next[s.rows[k]]++] = k;
+	}
+
+	s.entry_alive.assign(nnz, true);
+	s.row_alive.assign(num_rows, true);
+	s.col_alive.assign(num_cols, true);
+	s.lb.assign(num_cols, -INF);
+	s.ub.assign(num_cols, INF);
+	s.value.assign(num_cols, 0);
+
+	PresolveInfo info;
+	info.orig_rows = num_rows;
+	info.orig_cols = num_cols;
+
+	for (int i = s.num_reducible - 1; i >= 0; i--) {
+		if (s.row_count[i] <= 1) {
+			s.queue.push_back(i);
+		}
+	}
+	while (!s.queue.empty()) {
+		int row = s.queue.back();
+		s.queue.pop_back();
+		if (!s.row_alive[row]) {
+			continue;
+		}
+		if (!reduce_row(s, row, num_zero_rows, tol)) {
+			info.status = PRESOLVE_INFEASIBLE;
+			return info;
+		}
+	}
+
+	/* Columns without entries are unconstrained apart from their bounds.
+	   Unless the objective depends on them they get the value closest to
+	   zero */
+	for (int j = 0; j < num_cols; j++) {
+		if (s.col_alive[j] && s.col_count[j] == 0 && obj_vec[j] == 0) {
+			s.col_alive[j] = false;
+			s.value[j] = free_column_value(s.lb[j], s.ub[j]);
+		}
+	}
+
+	std::vector<int> new_row(num_rows, -1);
+	for (int i = 0; i < num_rows; i++) {
+		if (s.row_alive[i]) {
+			new_row[i] = info.row_map.size();
+			info.row_map.push_back(i);
+			if (i < num_zero_rows) {
+				info.num_zero_rows++;
+			} else if (i < s.num_reducible) {
+				info.num_nonneg_rows++;
+			}
+		}
+	}
+	std::vector<int> new_col(num_cols, -1);
+	for (int j = 0; j < num_cols; j++) {
+		if (s.col_alive[j]) {
+			new_col[j] = info.col_map.size();
+			info.col_map.push_back(j);
+			info.col_lb.push_back(s.lb[j]);
+			info.col_ub.push_back(s.ub[j]);
+		}
+	}
+	info.col_value = s.value;
+
+	/* Entries stay sorted by column, then row, since both maps are
+	   increasing */
+	long out = 0;
+	for (long k = 0; k < nnz; k++) {
+		if (s.entry_alive[k]) {
+			data.V[out] = static_cast<Scalar>(s.vals[k]);
+			data.I[out] = new_row[s.rows[k]];
+			data.J[out] = new_col[s.cols[k]];
+			out++;
+		}
+	}
+	data.V.resize(out);
+	data.I.resize(out);
+	data.J.resize(out);
+	data.const_vec.resize(info.row_map.size());
+	for (unsigned i = 0; i < info.row_map.size(); i++) {
+		data.const_vec[i] = static_cast<Scalar>(s.const_vec[info.row_map[i]]);
+	}
+
+	/* Removed columns move their share of the objective to the offset */
+	if (!data.obj_vec.empty()) {
+		double offset = data.obj_offset;
+		for (int j = 0; j < num_cols; j++) {
+			if (!s.col_alive[j]) {
+				offset += obj_vec[j] * s.value[j];
+			}
+		}
+		data.obj_vec.resize(info.col_map.size());
+		for (unsigned k = 0; k < info.col_map.size(); k++) {
+			data.obj_vec[k] = static_cast<Scalar>(obj_vec[info.col_map[k]]);
+		}
+		data.obj_offset = static_cast<Scalar>(offset);
+	}
+	data.stats = MatrixStats();
+	return info;
+}
+
+/**
+ * The rows of canonicalized problem data: the entries of row i are
+ * ROW_COLS[ROW_START[i]] ... with values ROW_VALS[...], sorted by column.
+ */
+class RowMatrix {
+public:
+	std::vector<long> row_start;
+	std::vector<int> row_cols;
+	std::vector<double> row_vals;
+
+	long row_nnz(int row) const {
+		return row_start[row + 1] - row_start[row];
+	}
+};
+
+template <typename Scalar>
+static RowMatrix get_rows(const ProblemDataT<Scalar> &data) {
+	int num_rows = data.get_num_rows();
+	long nnz = data.V.size();
+	RowMatrix result;
+	result.row_start.assign(num_rows + 1, 0);
+	for (long k = 0; k < nnz; k++) {
+		result.row_start[data.I[k] + 1]++;
+	}
+	for (int i = 0; i < num_rows; i++) {
+		result.row_start[i + 1] += result.row_start[i];
+	}
+	result.row_cols.resize(nnz);
+	result.row_vals.resize(nnz);
+	std::vector<long> next(result.row_start.begin(), result.row_start.end() - 1);
+	for (long k = 0; k < nnz; k++) {
+		long dest = next[data.I[k]]++;
+		result.row_cols[dest] = data.J[k];
+		result.row_vals[dest] = data.V[k];
+	}
+	return result;
+}
+
+/**
+ * Hashes the pattern of ROW and its values divided by the first value.
+ * Values are rounded to about 1 / QUANTUM relative precision so that rows
+ * equal up to rounding usually hash together; rows that straddle a rounding
+ * boundary are missed, which only makes the pass less thorough. The bits of
+ * the rounded value are hashed rather than its conversion to an integer,
+ * which overflows for large ratios.
+ */
+static unsigned long hash_row(const RowMatrix &m, int row, double quantum) {
+	unsigned long h = 1469598103934665603UL;
+	long start = m.row_start[row];
+	double first = m.row_vals[start];
+	for (long p = start; p < m.row_start[row + 1]; p++) {
+		/* Adding zero turns -0 into +0, so both hash the same */
+		double scaled = std::floor(m.row_vals[p] / first * quantum + 0.5) + 0.0;
+		uint64_t bits;
+		std::memcpy(&bits, &scaled, sizeof(bits));
+		unsigned long word = (unsigned long) m.row_cols[p] * 0x9e3779b97f4a7c15UL
+		                     ^ (unsigned long) bits;
+		h = (h ^ word) * 1099511628211UL;
+	}
+	return h;
+}
+
+/**
+ * Returns true if row A is a multiple of row B to within TOL.
+ */
+static bool rows_parallel(const RowMatrix &m, int a, int b, double tol) {
+	if (m.row_nnz(a) != m.row_nnz(b)) {
+		return false;
+	}
+	long pa = m.row_start[a];
+	long pb = m.row_start[b];
+	double first_a = m.row_vals[pa];
+	double first_b = m.row_vals[pb];
+	for (long k = 0; k < m.row_nnz(a); k++) {
+		if (m.row_cols[pa + k] != m.row_cols[pb + k]) {
+			return false;
+		}
+		double va = m.row_vals[pa + k] / first_a;
+		double vb = m.row_vals[pb + k] / first_b;
+		if (std::fabs(va - vb) > tol * std::max(1.0, std::fabs(vb))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static ParallelRows find_parallel_rows(const RowMatrix &m, int num_rows,
+                                       double tol) {
+	ParallelRows result;
+	result.representative.assign(num_rows, -1);
+	result.ratio.assign(num_rows, 1);
+
+	double quantum = 1 / std::max(tol, 1e-12);
+	std::vector<std::pair<unsigned long, int> > keys;
+	keys.reserve(num_rows);
+	for (int i = 0; i < num_rows; i++) {
+		if (m.row_nnz(i) > 0) {
+			keys.push_back(std::make_pair(0UL, i));
+		}
+	}
+	parallel_for(keys.size(), [&](long begin, long end) {
+		for (long k = begin; k < end; k++) {
+			keys[k].first = hash_row(m, keys[k].second, quantum);
+		}
+	});
+	std::sort(keys.begin(), keys.end());
+
+	/* Within a run of equal hashes, compare each row with the
+	   representatives found so far in the run */
+	unsigned long k = 0;
+	while (k < keys.size()) {
+		unsigned long end = k;
+		while (end < keys.size() && keys[end].first == keys[k].first) {
+			end++;
+		}
+		std::vector<int> reps;
+		for (unsigned long p = k; p < end; p++) {
+			int row = keys[p].second;
+			for (unsigned r = 0; r < reps.size(); r++) {
+				if (rows_parallel(m, row, reps[r], tol)) {
+					result.representative[row] = reps[r];
+					result.ratio[row] = m.row_vals[m.row_start[row]] /
+					                    m.row_vals[m.row_start[reps[r]]];
+					result.num_parallel++;
+					break;
+				}
+			}
+			if (result.representative[row] < 0) {
+				reps.push_back(row);
+			}
+		}
+		k = end;
+	}
+	return result;
+}
+
+template <typename Scalar>
+static ParallelRows find_parallel_rows_t(ProblemDataT<Scalar> &data,
+                                         double tol) {
+	canonicalize(data, 0);
+	RowMatrix m = get_rows(data);
+	return find_parallel_rows(m, data.get_num_rows(), tol);
+}
+
+/**
+ * Implementation of merge_parallel_rows for either precision.
+ *
+ * For every group, each row is read as a bound on n x, where n is the
+ * group's row normalized by its first entry: row i is s_i n x + b_i, with s_i
+ * the first entry of row i.
+ */
+template <typename Scalar>
+static PresolveInfo merge_parallel_rows_t(ProblemDataT<Scalar> &data,
+                                          int num_zero_rows,
+                                          int num_nonneg_rows, int num_cols,
+                                          double tol) {
+	data.densify_const_vec();
+	int num_rows = data.const_vec.size();
+	int num_reducible = num_zero_rows + num_nonneg_rows;
+	if (num_zero_rows < 0 || num_nonneg_rows < 0 || num_reducible > num_rows) {
+		std::cerr << "Error: merge_parallel_rows row sections exceed the "
+		          << "number of rows" << std::endl;
+		exit(-1);
+	}
+	canonicalize(data, 0);
+	RowMatrix m = get_rows(data);
+	ParallelRows parallel = find_parallel_rows(m, num_rows, tol);
+
+	PresolveInfo info;
+	info.orig_rows = num_rows;
+	if (!data.J.empty()) {
+		num_cols = std::max(num_cols, data.J.back() + 1);
+	}
+	info.orig_cols = std::max(num_cols, (int) data.obj_vec.size());
+
+	/* Per group (indexed by representative): the equality row if any, and
+	   the tightest upper and lower bound on n x with their rows */
+	std::vector<int> group_eq(num_rows, -1);
+	std::vector<int> group_upper(num_rows, -1);
+	std::vector<int> group_lower(num_rows, -1);
+	std::vector<double> upper(num_rows, INF);
+	std::vector<double> lower(num_rows, -INF);
+	std::vector<bool> keep(num_rows, true);
+	for (int i = 0; i < num_reducible; i++) {
+		if (m.row_nnz(i) == 0) {
+			continue;
+		}
+		/* Representatives come first, so they are reducible rows too */
+		int rep = parallel.representative[i];
+		if (rep < 0) {
+			rep = i;
+		}
+		double s = m.row_vals[m.row_start[i]];
+		double value = -data.const_vec[i] / s;
+		if (i < num_zero_rows) {
+			if (group_eq[rep] < 0) {
+				group_eq[rep] = i;
+				continue;
+			}
+			int e = group_eq[rep];
+			double value_e = -data.const_vec[e] / m.row_vals[m.row_start[e]];
+			if (std::fabs(s * (value - value_e)) > tol) {
+				info.status = PRESOLVE_INFEASIBLE;
+				return info;
+			}
+			keep[i] = false;
+		} else if (s > 0) {
+			if (value < upper[rep]) {
+				if (group_upper[rep] >= 0) {
+					keep[group_upper[rep]] = false;
+				}
+				upper[rep] = value;
+				group_upper[rep] = i;
+			} else {
+				keep[i] = false;
+			}
+		} else {
+			if (value > lower[rep]) {
+				if (group_lower[rep] >= 0) {
+					keep[group_lower[rep]] = false;
+				}
+				lower[rep] = value;
+				group_lower[rep] = i;
+			} else {
+				keep[i] = false;
+			}
+		}
+	}
+
+	/* Inequalities are redundant next to an equality of the same group,
+	   if the equality satisfies them */
+	for (int rep = 0; rep < num_reducible; rep++) {
+		if (lower[rep] > upper[rep] + tol) {
+			info.status = PRESOLVE_INFEASIBLE;
+			return info;
+		}
+		int e = group_eq[rep];
+		if (e < 0) {
+			continue;
+		}
+		double value_e = -data.const_vec[e] / m.row_vals[m.row_start[e]];
+		if (value_e > upper[rep] + tol || value_e < lower[rep] - tol) {
+			info.status = PRESOLVE_INFEASIBLE;
+			return info;
+		}
+		if (group_upper[rep] >= 0) {
+			keep[group_upper[rep]] = false;
+		}
+		if (group_lower[rep] >= 0) {
+			keep[group_lower[rep]] = false;
+		}
+	}
+
+	std::vector<int> new_row(num_rows, -1);
+	for (int i = 0; i < num_rows; i++) {
+		if (keep[i]) {
+			new_row[i] = info.row_map.size();
+			info.row_map.push_back(i);
+			if (i < num_zero_rows) {
+				info.num_zero_rows++;
+			} else if (i < num_reducible) {
+				info.num_nonneg_rows++;
+			}
+		}
+	}
+	for (int j = 0; j < info.orig_cols; j++) {
+		info.col_map.push_back(j);
+		info.col_lb.push_back(-INF);
+		info.col_ub.push_back(INF);
+	}
+	info.col_value.assign(info.orig_cols, 0);
+
+	long out = 0;
+	for (unsigned long k = 0; k < data.V.size(); k++) {
+		if (keep[data.I[k]]) {
+			data.V[out] = data.V[k];
+			data.I[out] = new_row[data.I[k]];
+			data.J[out] = data.J[k];
+			out++;
+		}
+	}
+	data.V.resize(out);
+	data.I.resize(out);
+	data.J.resize(out);
+	for (unsigned i = 0; i < info.row_map.size(); i++) {
+		data.const_vec[i] = data.const_vec[info.row_map[i]];
+	}
+	data.const_vec.resize(info.row_map.size());
+	data.stats = MatrixStats();
+	return info;
+}
+
+/***************************
+ * PRESOLVE
+ ***************************/
+
+PresolveInfo presolve(ProblemData &data, int num_zero_rows,
+                      int num_nonneg_rows, int num_cols, double tol) {
+	return presolve_t(data, num_zero_rows, num_nonneg_rows, num_cols, tol);
+}
+
+PresolveInfo presolve(ProblemDataFloat &data, int num_zero_rows,
+                      int num_nonneg_rows, int num_cols, double tol) {
+	return presolve_t(data, num_zero_rows, num_nonneg_rows, num_cols, tol);
+}
+
+std::vector<double> postsolve(const PresolveInfo &info,
+                              const std::vector<double> &x) {
+	if (x.size() != info.col_map.size()) {
+		std::cerr << "Error: postsolve solution has the wrong length"
+		          << std::endl;
+		exit(-1);
+	}
+	std::vector<double> result = info.col_value;
+	for (unsigned k = 0; k < x.size(); k++) {
+		result[info.col_map[k]] = x[k];
+	}
+	return result;
+}
+
+ParallelRows find_parallel_rows(ProblemData &data, double tol) {
+	return find_parallel_rows_t(data, tol);
+}
+
+ParallelRows find_parallel_rows(ProblemDataFloat &data, double tol) {
+	return find_parallel_rows_t(data, tol);
+}
+
+PresolveInfo merge_parallel_rows(ProblemData &data, int num_zero_rows,
+                                 int num_nonneg_rows, int num_cols,
+                                 double tol) {
+	return merge_parallel_rows_t(data, num_zero_rows, num_nonneg_rows,
+	                             num_cols, tol);
+}
+
+PresolveInfo merge_parallel_rows(ProblemDataFloat &data, int num_zero_rows,
+                                 int num_nonneg_rows, int num_cols,
+                                 double tol) {
+	return merge_parallel_rows_t(data, num_zero_rows, num_nonneg_rows,
+	                             num_cols, tol);
+}
@@ -0,0 +1,133 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Presolve pass over the ProblemData returned by build_matrix.
+//
+// Rows of the problem data are read as constraints on the columns x:
+// the first NUM_ZERO_ROWS rows are equalities  a_i x + b_i == 0, the next
+// NUM_NONNEG_ROWS rows are inequalities  a_i x + b_i <= 0, and any remaining
+// rows (second order, semidefinite, ... cones) are kept as they are. Here
+// b is the constant vector; a sparse constant vector is densified first.
+
+#ifndef PRESOLVE_H
+#define PRESOLVE_H
+
+#include "ProblemData.hpp"
+#include <vector>
+
+enum PresolveStatus {
+	PRESOLVE_OK,
+	PRESOLVE_INFEASIBLE
+};
+
+/* Result of PRESOLVE, and everything needed to map a solution of the
+ * reduced problem back to the original columns. */
+class PresolveInfo {
+public:
+	PresolveStatus status;
+
+	/* Size of the problem before presolve */
+	int orig_rows;
+	int orig_cols;
+
+	/* Sizes of the equality and inequality sections after presolve */
+	int num_zero_rows;
+	int num_nonneg_rows;
+
+	/* Original index of each row and column of the reduced problem */
+	std::vector<int> row_map;
+	std::vector<int> col_map;
+
+	/* Bounds LB <= x <= UB on the columns of the reduced problem, from
+	 * singleton inequality rows. Unbounded sides are +/- infinity. */
+	std::vector<double> col_lb;
+	std::vector<double> col_ub;
+
+	/* Value of every original column that was removed. Fixed columns get
+	 * their fixed value and empty columns the point of their bounds closest
+	 * to zero. Empty columns with a nonzero entry in ProblemData::obj_vec are
+	 * kept. Entries of kept columns are overwritten by POSTSOLVE. */
+	std::vector<double> col_value;
+
+	PresolveInfo() {
+		status = PRESOLVE_OK;
+		orig_rows = 0;
+		orig_cols = 0;
+		num_zero_rows = 0;
+		num_nonneg_rows = 0;
+	}
+};
+
+/* Removes empty rows and columns, turns singleton rows into column bounds
+ * and substitutes out fixed columns, repeating until nothing changes. DATA
+ * is canonicalized and then reduced in place; its id_to_col and const_to_row
+ * still refer to the original columns and rows. NUM_COLS is the number of
+ * columns of the matrix, or -1 to use one past the largest column index.
+ * If DATA has an objective, OBJ_VEC is reduced to the kept columns and the
+ * contribution of the removed ones is added to OBJ_OFFSET.
+ *
+ * TOL is the feasibility tolerance for removed rows. If the problem is found
+ * to be infeasible the returned status is PRESOLVE_INFEASIBLE and DATA is
+ * left in an unspecified state. */
+PresolveInfo presolve(ProblemData &data, int num_zero_rows,
+                      int num_nonneg_rows, int num_cols, double tol);
+PresolveInfo presolve(ProblemDataFloat &data, int num_zero_rows,
+                      int num_nonneg_rows, int num_cols, double tol);
+
+/* Groups of rows that are scalar multiples of each other. */
+class ParallelRows {
+public:
+	/* For each row, the first row of its group, or -1 if the row is not
+	 * parallel to any earlier row. Empty rows are never grouped. */
+	std::vector<int> representative;
+
+	/* Row i equals RATIO[i] times row REPRESENTATIVE[i] (1 for rows that
+	 * are not grouped). Duplicate rows have ratio 1. */
+	std::vector<double> ratio;
+
+	/* Number of rows with a representative */
+	int num_parallel;
+
+	ParallelRows() {
+		num_parallel = 0;
+	}
+};
+
+/* Finds duplicate and parallel rows by hashing the column pattern and the
+ * normalized values of every row, then comparing rows with equal hashes.
+ * Values match if they agree to within TOL relative to the row's first
+ * entry. DATA is canonicalized first. */
+ParallelRows find_parallel_rows(ProblemData &data, double tol);
+ParallelRows find_parallel_rows(ProblemDataFloat &data, double tol);
+
+/* Removes rows made redundant by a parallel row, with the row sections of
+ * PRESOLVE: an equality makes parallel equalities and inequalities
+ * redundant, and of the parallel inequalities bounding a x from the same
+ * side only the tightest is kept. Conflicting rows give PRESOLVE_INFEASIBLE.
+ * Rows in other cones are never removed. Columns are not changed, so the
+ * returned col_map is the identity over NUM_COLS columns, with NUM_COLS as
+ * for PRESOLVE. */
+PresolveInfo merge_parallel_rows(ProblemData &data, int num_zero_rows,
+                                 int num_nonneg_rows, int num_cols,
+                                 double tol);
+PresolveInfo merge_parallel_rows(ProblemDataFloat &data, int num_zero_rows,
+                                 int num_nonneg_rows, int num_cols,
+                                 double tol);
+
+/* Maps the solution X of the reduced problem to the original columns */
+std::vector<double> postsolve(const PresolveInfo &info,
+                              const std::vector<double> &x);
+
+#endif
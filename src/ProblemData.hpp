@@ -16,21 +16,147 @@
 #ifndef PROBLEMDATA_H
 #define PROBLEMDATA_H
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <vector>
 #include <map>
+#include "MemoryResource.hpp"
+
+/* Per row and per column statistics of the problem matrix, for solvers that
+ * equilibrate A. Filled by BUILD_MATRIX when BuildOptions::compute_stats is
+ * set. Norms are of the matrix before any scaling is applied. */
+class MatrixStats {
+public:
+	std::vector<double> row_norm_inf;
+	std::vector<double> row_norm_two;
+	std::vector<int> row_nnz;
+
+	std::vector<double> col_norm_inf;
+	std::vector<double> col_norm_two;
+	std::vector<int> col_nnz;
+
+	/* Scaling applied by BuildOptions::equilibrate (or equilibrate in
+	 * ProblemDataOperations.hpp): the stored matrix and constant vector are
+	 * diag(ROW_SCALE) * A * diag(COL_SCALE) and diag(ROW_SCALE) * b. Empty
+	 * if no scaling was applied. */
+	std::vector<double> row_scale;
+	std::vector<double> col_scale;
+
+	/* Clears the statistics and sizes the row statistics for NUM_ROWS rows */
+	void reset(int num_rows) {
+		row_norm_inf.assign(num_rows, 0);
+		row_norm_two.assign(num_rows, 0);
+		row_nnz.assign(num_rows, 0);
+		col_norm_inf.clear();
+		col_norm_two.clear();
+		col_nnz.clear();
+	}
+
+	/* Makes room for columns up to NUM_COLS - 1 */
+	void reserve_cols(int num_cols) {
+		if ((int) col_nnz.size() < num_cols) {
+			col_norm_inf.resize(num_cols, 0);
+			col_norm_two.resize(num_cols, 0);
+			col_nnz.resize(num_cols, 0);
+		}
+	}
+
+	/* Accumulates one entry. While accumulating, the two-norm fields hold
+	 * sums of squares; call FINALIZE once all entries have been added. */
+	void add_entry(int row, int col, double value) {
+		double abs_value = std::fabs(value);
+		row_norm_inf[row] = std::max(row_norm_inf[row], abs_value);
+		row_norm_two[row] += value * value;
+		row_nnz[row]++;
+		col_norm_inf[col] = std::max(col_norm_inf[col], abs_value);
+		col_norm_two[col] += value * value;
+		col_nnz[col]++;
+	}
+
+	void finalize() {
+		for (unsigned i = 0; i < row_norm_two.size(); i++) {
+			row_norm_two[i] = std::sqrt(row_norm_two[i]);
+		}
+		for (unsigned j = 0; j < col_norm_two.size(); j++) {
+			col_norm_two[j] = std::sqrt(col_norm_two[j]);
+		}
+	}
+
+	/* Numpy views and bulk setters for pickling, see ProblemDataT. FIELD
+	 * selects ROW_NORM_INF, ROW_NORM_TWO, COL_NORM_INF, COL_NORM_TWO,
+	 * ROW_SCALE or COL_SCALE (0 to 5) for the norms, and ROW_NNZ or COL_NNZ
+	 * (0 or 1) for the counts. */
+	void viewNorms(int field, double** view_data, int* view_len) {
+		std::vector<double> &values = norms(field);
+		*view_data = values.empty() ? NULL : &values[0];
+		*view_len = values.size();
+	}
+
+	void viewCounts(int field, int** idx_view, int* idx_len) {
+		std::vector<int> &values = counts(field);
+		*idx_view = values.empty() ? NULL : &values[0];
+		*idx_len = values.size();
+	}
+
+	void setNorms(int field, double* in_data, int in_len) {
+		norms(field).assign(in_data, in_data + in_len);
+	}
+
+	void setCounts(int field, int* in_idxs, int in_len) {
+		counts(field).assign(in_idxs, in_idxs + in_len);
+	}
+
+private:
+	std::vector<double> &norms(int field) {
+		std::vector<double> *fields[] = {&row_norm_inf, &row_norm_two,
+		                                 &col_norm_inf, &col_norm_two,
+		                                 &row_scale, &col_scale};
+		assert(field >= 0 && field < 6);
+		return *fields[field];
+	}
+
+	std::vector<int> &counts(int field) {
+		assert(field == 0 || field == 1);
+		return field == 0 ? row_nnz : col_nnz;
+	}
+};
 
 /* Stores the result of calling BUILD_MATRIX on a collection of LinOp
- * trees. */
-class ProblemData {
+ * trees. SCALAR is the type of the values in V and CONST_VEC; coefficients
+ * are always computed in double precision and only rounded to SCALAR when
+ * they are written out. */
+template <typename Scalar>
+class ProblemDataT {
 public:
 	/* COO sparse matrix representation. V stores the data, I the row indices
-	 * and J the column indices. */
-	std::vector<double> V;
-	std::vector<int> I;
-	std::vector<int> J;
+	 * and J the column indices. Their memory comes from the MemoryResource
+	 * of the ExecutionContext of the build, see ExecutionContext.hpp. From
+	 * Python they are read with getV, getI and getJ. */
+#ifndef SWIG
+	Buffer<Scalar> V;
+	Buffer<int> I;
+	Buffer<int> J;
+#endif
 
 	/* Dense matrix representation of the constant vector */
-	std::vector<double> const_vec;
+	std::vector<Scalar> const_vec;
+
+	/* Sparse representation of the constant vector, used instead of
+	 * CONST_VEC if SPARSE_CONST is set: entry CONST_IDX[k] is CONST_VAL[k],
+	 * with indices sorted and unique, and the other entries of the
+	 * CONST_LEN long vector are zero. CONST_VEC is then empty. */
+	bool sparse_const;
+	int const_len;
+	std::vector<int> const_idx;
+	std::vector<Scalar> const_val;
+
+	/* Objective c^T x + d, if an objective was passed to BUILD_MATRIX: OBJ_VEC
+	 * is c, with one entry per column of the matrix, and OBJ_OFFSET is d.
+	 * OBJ_VEC is empty if there was no objective. */
+	std::vector<Scalar> obj_vec;
+	Scalar obj_offset;
 
 	/* Map of variable_id to column in the problemData matrix */
 	std::map<int, int> id_to_col;
@@ -38,6 +164,42 @@ public:
 	/* Map of constant linOp's to row in the problemData matrix  */
 	std::map<int, int> const_to_row;
 
+	/* Row and column statistics, see MatrixStats */
+	MatrixStats stats;
+
+	ProblemDataT() {
+		obj_offset = 0;
+		sparse_const = false;
+		const_len = 0;
+	}
+
+	/* Number of entries in V, I and J */
+	int get_nnz() const {
+		return V.size();
+	}
+
+	/* Number of rows, the length of the constant vector in either
+	 * representation */
+	int get_num_rows() const {
+		return sparse_const ? const_len : (int) const_vec.size();
+	}
+
+	/* Switches to the dense CONST_VEC. Passes over the problem data that
+	 * need random access to the constant vector call this first. */
+	void densify_const_vec() {
+		if (!sparse_const) {
+			return;
+		}
+		const_vec.assign(const_len, 0);
+		for (unsigned k = 0; k < const_idx.size(); k++) {
+			const_vec[const_idx[k]] = const_val[k];
+		}
+		sparse_const = false;
+		const_len = 0;
+		std::vector<int>().swap(const_idx);
+		std::vector<Scalar>().swap(const_val);
+	}
+
 	/*******************************************
 	 * The functions below return problemData vectors as contiguous 1d
 	 * numpy arrays.
@@ -58,7 +220,7 @@ public:
 	/**
 	 * Returns the data vector V as a contiguous 1D numpy array.
 	 */
-	void getV(double* values, int num_values) {
+	void getV(Scalar* values, int num_values) {
 		for (int i = 0; i < num_values; i++) {
 			values[i] = V[i];
 		}
@@ -83,13 +245,221 @@ public:
 	}
 
 	/**
-	 * Returns the CONST_VEC as a contiguous 1D numpy array.
+	 * Returns the CONST_VEC as a contiguous 1D numpy array. A sparse
+	 * constant vector is densified into VALUES, which must have
+	 * get_num_rows() entries.
 	 */
-	void getConstVec(double* values, int num_values) {
+	void getConstVec(Scalar* values, int num_values) {
+		if (sparse_const) {
+			std::fill(values, values + num_values, Scalar(0));
+			for (unsigned k = 0; k < const_idx.size(); k++) {
+				values[const_idx[k]] = const_val[k];
+			}
+			return;
+		}
 		for (int i = 0; i < num_values; i++) {
 			values[i] = const_vec[i];
 		}
 	}
+
+	/**
+	 * Returns the indices CONST_IDX of a sparse constant vector.
+	 */
+	void getConstIdx(double* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = const_idx[i];
+		}
+	}
+
+	/**
+	 * Returns the values CONST_VAL of a sparse constant vector.
+	 */
+	void getConstVal(Scalar* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = const_val[i];
+		}
+	}
+
+	/**
+	 * Returns the OBJ_VEC as a contiguous 1D numpy array.
+	 */
+	void getObjVec(Scalar* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = obj_vec[i];
+		}
+	}
+
+	/*******************************************
+	 * The functions below expose the problemData vectors as numpy arrays
+	 * that share memory with this object, and load them back from numpy
+	 * arrays. They are used to pickle problemData with out-of-band buffers
+	 * (pickle protocol 5).
+	 *
+	 * The views are only valid while this object is alive and its vectors
+	 * are not resized.
+	 ********************************************/
+
+	void viewV(Scalar** view_data, int* view_len) {
+		*view_data = V.empty() ? NULL : &V[0];
+		*view_len = V.size();
+	}
+
+	void viewI(int** idx_view, int* idx_len) {
+		*idx_view = I.empty() ? NULL : &I[0];
+		*idx_len = I.size();
+	}
+
+	void viewJ(int** idx_view, int* idx_len) {
+		*idx_view = J.empty() ? NULL : &J[0];
+		*idx_len = J.size();
+	}
+
+	void viewConstVec(Scalar** view_data, int* view_len) {
+		*view_data = const_vec.empty() ? NULL : &const_vec[0];
+		*view_len = const_vec.size();
+	}
+
+	void viewObjVec(Scalar** view_data, int* view_len) {
+		*view_data = obj_vec.empty() ? NULL : &obj_vec[0];
+		*view_len = obj_vec.size();
+	}
+
+	void viewConstIdx(int** idx_view, int* idx_len) {
+		*idx_view = const_idx.empty() ? NULL : &const_idx[0];
+		*idx_len = const_idx.size();
+	}
+
+	void viewConstVal(Scalar** view_data, int* view_len) {
+		*view_data = const_val.empty() ? NULL : &const_val[0];
+		*view_len = const_val.size();
+	}
+
+	void setV(Scalar* in_data, int in_len) {
+		V.assign(in_data, in_data + in_len);
+	}
+
+	void setI(int* in_idxs, int in_len) {
+		I.assign(in_idxs, in_idxs + in_len);
+	}
+
+	void setJ(int* in_idxs, int in_len) {
+		J.assign(in_idxs, in_idxs + in_len);
+	}
+
+	void setConstVec(Scalar* in_data, int in_len) {
+		const_vec.assign(in_data, in_data + in_len);
+	}
+
+	void setObjVec(Scalar* in_data, int in_len) {
+		obj_vec.assign(in_data, in_data + in_len);
+	}
+
+	void setConstIdx(int* in_idxs, int in_len) {
+		const_idx.assign(in_idxs, in_idxs + in_len);
+	}
+
+	void setConstVal(Scalar* in_data, int in_len) {
+		const_val.assign(in_data, in_data + in_len);
+	}
+};
+
+/* Double precision problem data, returned by BUILD_MATRIX */
+typedef ProblemDataT<double> ProblemData;
+
+/* Single precision problem data, returned by BUILD_MATRIX_FLOAT. Halves the
+ * memory used by V and CONST_VEC. */
+typedef ProblemDataT<float> ProblemDataFloat;
+
+/* Cone of a constraint, in the order the cones are laid out by
+ * BUILD_CONE_MATRIX */
+enum ConeType {
+	CONE_ZERO,
+	CONE_NONNEG,
+	CONE_SOC,
+	CONE_PSD,
+	CONE_EXP,
+	NUM_CONE_TYPES
+};
+
+/* Result of BUILD_CONE_MATRIX: the constraints partitioned into the
+ * equality block A x + b (the zero cone) and the inequality block G x + h
+ * (all other cones, ordered by cone type). Constraints of the same cone
+ * keep their relative order, so cones spanning several consecutive
+ * constraints stay contiguous. Both blocks share the column layout in
+ * ID_TO_COL; const_to_row of each block maps constraint indices to rows
+ * within that block. */
+template <typename Scalar>
+class ConeProblemDataT {
+public:
+	ProblemDataT<Scalar> eq;
+	ProblemDataT<Scalar> ineq;
+
+	/* Number of rows of each cone type, indexed by ConeType */
+	std::vector<int> cone_rows;
+
+	/* Number of rows of each constraint, grouped by ConeType and in the
+	 * order the constraints are laid out in their block. Solvers read the
+	 * dimensions of the second order and semidefinite cones from these. */
+	std::vector< std::vector<int> > cone_sizes;
+};
+
+typedef ConeProblemDataT<double> ConeProblemData;
+typedef ConeProblemDataT<float> ConeProblemDataFloat;
+
+/* Result of BUILD_QUAD_MATRIX: the quadratic objective
+ *
+ * 		(1/2) x^T P x + q^T x + r
+ *
+ * equal to the sum of the quadratic terms. Only the upper triangle of the
+ * symmetric P is stored, in compressed sparse column form, as OSQP expects:
+ * the rows and values of column j are P_INDICES and P_DATA at positions
+ * P_INDPTR[j] ... P_INDPTR[j + 1] - 1. */
+class QuadProblemData {
+public:
+	std::vector<double> P_data;
+	std::vector<int> P_indices;
+	std::vector<int> P_indptr;
+
+	/* Dense linear term and constant offset */
+	std::vector<double> q;
+	double r;
+
+	/* Number of rows and columns of P */
+	int num_cols;
+
+	/* Map of variable_id to column, including variables added by
+	 * BUILD_QUAD_MATRIX */
+	std::map<int, int> id_to_col;
+
+	QuadProblemData() {
+		r = 0;
+		num_cols = 0;
+	}
+
+	/* Numpy accessors, see ProblemDataT */
+	void getPData(double* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = P_data[i];
+		}
+	}
+
+	void getPIndices(double* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = P_indices[i];
+		}
+	}
+
+	void getPIndptr(double* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = P_indptr[i];
+		}
+	}
+
+	void getQ(double* values, int num_values) {
+		for (int i = 0; i < num_values; i++) {
+			values[i] = q[i];
+		}
+	}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ProblemDataOperations.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+/*******************
+ * HELPER FUNCTIONS
+ *******************/
+
+/**
+ * Returns one plus the largest index in IDX, or 0 if IDX is empty.
+ */
+static int get_dimension(const Buffer<int> &idx) {
+	long n = idx.size();
+	int num_chunks = get_num_chunks(n);
+	std::vector<int> chunk_max(num_chunks, -1);
+	parallel_chunks(n, num_chunks, [&](int chunk, long begin, long end) {
+		int result = -1;
+		for (long k = begin; k < end; k++) {
+			result = std::max(result, idx[k]);
+		}
+		chunk_max[chunk] = result;
+	});
+	return *std::max_element(chunk_max.begin(), chunk_max.end()) + 1;
+}
+
+/**
+ * Returns the columns [first, last) whose entries start within
+ * [BEGIN, END) of the column pointer array COL_START. Used to split work
+ * across columns with balanced numbers of entries.
+ */
+static std::pair<int, int> column_range(const std::vector<long> &col_start,
+                                        long begin, long end) {
+	int num_cols = col_start.size() - 1;
+	int first = std::lower_bound(col_start.begin(), col_start.end() - 1, begin)
+	            - col_start.begin();
+	int last = std::lower_bound(col_start.begin(), col_start.end() - 1, end)
+	           - col_start.begin();
+	if (end >= col_start[num_cols]) {
+		last = num_cols;
+	}
+	return std::make_pair(first, last);
+}
+
+/**
+ * Sorts the entries ROWS[start, end), VALS[start, end) of one column by row,
+ * sums duplicates and drops entries with |v| <= ZERO_TOL. The surviving
+ * entries are written back starting at START.
+ *
+ * Returns the number of surviving entries.
+ */
+static long merge_column(Buffer<int> &rows, Buffer<double> &vals,
+                         long start, long end, double zero_tol) {
+	bool sorted = true;
+	for (long k = start + 1; k < end && sorted; k++) {
+		sorted = rows[k - 1] <= rows[k];
+	}
+	if (!sorted) {
+		std::vector<std::pair<int, double> > entries;
+		entries.reserve(end - start);
+		for (long k = start; k < end; k++) {
+			entries.push_back(std::make_pair(rows[k], vals[k]));
+		}
+		/* Stable, so duplicates are summed in their original order */
+		std::stable_sort(entries.begin(), entries.end(),
+		                 [](const std::pair<int, double> &a,
+		                    const std::pair<int, double> &b) {
+		                 	return a.first < b.first;
+		                 });
+		for (long k = start; k < end; k++) {
+			rows[k] = entries[k - start].first;
+			vals[k] = entries[k - start].second;
+		}
+	}
+
+	long out = start;
+	long k = start;
+	while (k < end) {
+		int row = rows[k];
+		double sum = 0;
+		for (; k < end && rows[k] == row; k++) {
+			sum += vals[k];
+		}
+		if (std::fabs(sum) > zero_tol) {
+			rows[out] = row;
+			vals[out] = sum;
+			out++;
+		}
+	}
+	return out - start;
+}
+
+/**
+ * Implementation of canonicalize for either precision.
+ *
+ * Entries are bucketed by column with a parallel counting sort: each chunk
+ * of the input counts its entries per column, and then scatters them to
+ * disjoint, precomputed positions, which keeps the order within a column
+ * stable and the result deterministic. The columns are then sorted and
+ * merged independently.
+ */
+template <typename Scalar>
+static void canonicalize_t(ProblemDataT<Scalar> &data, double zero_tol) {
+	long nnz = data.V.size();
+	int num_cols = get_dimension(data.J);
+
+	/* Per chunk column counts cost NUM_CHUNKS * NUM_COLS memory, so use
+	   fewer chunks for very wide, very sparse matrices */
+	int num_chunks = get_num_chunks(nnz);
+	num_chunks = std::max(1L, std::min<long>(num_chunks,
+	                                         4 * nnz / (num_cols + 1)));
+
+	std::vector<std::vector<long> > offsets(num_chunks,
+	                                        std::vector<long>(num_cols, 0));
+	parallel_chunks(nnz, num_chunks, [&](int chunk, long begin, long end) {
+		std::vector<long> &count = offsets[chunk];
+		for (long k = begin; k < end; k++) {
+			count[data.J[k]]++;
+		}
+	});
+
+	/* Turn the counts into the position of each chunk within each column */
+	std::vector<long> col_start(num_cols + 1, 0);
+	for (int col = 0; col < num_cols; col++) {
+		long pos = col_start[col];
+		for (int chunk = 0; chunk < num_chunks; chunk++) {
+			long count = offsets[chunk][col];
+			offsets[chunk][col] = pos;
+			pos += count;
+		}
+		col_start[col + 1] = pos;
+	}
+
+	/* As large as the output, so they come from the same resource */
+	Buffer<int> rows(nnz);
+	Buffer<double> vals(nnz);
+	parallel_chunks(nnz, num_chunks, [&](int chunk, long begin, long end) {
+		std::vector<long> &pos = offsets[chunk];
+		for (long k = begin; k < end; k++) {
+			long dest = pos[data.J[k]]++;
+			rows[dest] = data.I[k];
+			vals[dest] = data.V[k];
+		}
+	});
+	offsets.clear();
+
+	/* Sort and merge each column, balancing chunks by number of entries */
+	std::vector<long> kept(num_cols, 0);
+	parallel_for(nnz, [&](long begin, long end) {
+		std::pair<int, int> cols = column_range(col_start, begin, end);
+		for (int col = cols.first; col < cols.second; col++) {
+			kept[col] = merge_column(rows, vals, col_start[col], col_start[col + 1],
+			                         zero_tol);
+		}
+	});
+
+	std::vector<long> out_start(num_cols + 1, 0);
+	for (int col = 0; col < num_cols; col++) {
+		out_start[col + 1] = out_start[col] + kept[col];
+	}
+	long out_nnz = out_start[num_cols];
+	data.V.resize(out_nnz);
+	data.I.resize(out_nnz);
+	data.J.resize(out_nnz);
+	parallel_for(nnz, [&](long begin, long end) {
+		std::pair<int, int> cols = column_range(col_start, begin, end);
+		for (int col = cols.first; col < cols.second; col++) {
+			long src = col_start[col];
+			long dest = out_start[col];
+			for (long k = 0; k < kept[col]; k++) {
+				data.V[dest + k] = static_cast<Scalar>(vals[src + k]);
+				data.I[dest + k] = rows[src + k];
+				data.J[dest + k] = col;
+			}
+		}
+	});
+}
+
+/**
+ * Implementation of compute_stats for either precision.
+ */
+template <typename Scalar>
+static void compute_stats_t(ProblemDataT<Scalar> &data) {
+	MatrixStats &stats = data.stats;
+	stats.reset(data.get_num_rows());
+	stats.reserve_cols(get_dimension(data.J));
+	for (unsigned k = 0; k < data.V.size(); k++) {
+		stats.add_entry(data.I[k], data.J[k], data.V[k]);
+	}
+	stats.finalize();
+}
+
+/**
+ * Returns the equilibration factor for a row or column with inf-norm NORM.
+ */
+static double get_scale(double norm) {
+	return norm > 0 ? 1 / std::sqrt(norm) : 1;
+}
+
+/**
+ * Implementation of equilibrate for either precision.
+ */
+template <typename Scalar>
+static void equilibrate_t(ProblemDataT<Scalar> &data) {
+	MatrixStats &stats = data.stats;
+	std::vector<double> row_scale = stats.row_scale;
+	std::vector<double> col_scale = stats.col_scale;
+
+	/* Statistics from the build are reused unless they are missing or were
+	   taken before an earlier scaling */
+	if ((int) stats.row_nnz.size() != data.get_num_rows() || !row_scale.empty()) {
+		compute_stats_t(data);
+	}
+
+	int num_rows = stats.row_norm_inf.size();
+	int num_cols = stats.col_norm_inf.size();
+	row_scale.resize(num_rows, 1);
+	col_scale.resize(std::max<int>(num_cols, col_scale.size()), 1);
+	std::vector<double> step_row(num_rows);
+	std::vector<double> step_col(num_cols);
+	for (int i = 0; i < num_rows; i++) {
+		step_row[i] = get_scale(stats.row_norm_inf[i]);
+		row_scale[i] *= step_row[i];
+	}
+	for (int j = 0; j < num_cols; j++) {
+		step_col[j] = get_scale(stats.col_norm_inf[j]);
+		col_scale[j] *= step_col[j];
+	}
+
+	parallel_for(data.V.size(), [&](long begin, long end) {
+		for (long k = begin; k < end; k++) {
+			double value = data.V[k] * step_row[data.I[k]] * step_col[data.J[k]];
+			data.V[k] = static_cast<Scalar>(value);
+		}
+	});
+	if (data.sparse_const) {
+		for (unsigned k = 0; k < data.const_idx.size(); k++) {
+			double value = data.const_val[k] * step_row[data.const_idx[k]];
+			data.const_val[k] = static_cast<Scalar>(value);
+		}
+	} else {
+		for (int i = 0; i < num_rows; i++) {
+			data.const_vec[i] = static_cast<Scalar>(data.const_vec[i] * step_row[i]);
+		}
+	}
+	/* The objective c^T x becomes c^T diag(COL_SCALE) x' */
+	for (int j = 0; j < std::min<int>(num_cols, data.obj_vec.size()); j++) {
+		data.obj_vec[j] = static_cast<Scalar>(data.obj_vec[j] * step_col[j]);
+	}
+	stats.row_scale = row_scale;
+	stats.col_scale = col_scale;
+}
+
+/***************************
+ * PROBLEMDATA OPERATIONS
+ ***************************/
+
+void canonicalize(ProblemData &data, double zero_tol) {
+	canonicalize_t(data, zero_tol);
+}
+
+void canonicalize(ProblemDataFloat &data, double zero_tol) {
+	canonicalize_t(data, zero_tol);
+}
+
+void compute_stats(ProblemData &data) {
+	compute_stats_t(data);
+}
+
+void compute_stats(ProblemDataFloat &data) {
+	compute_stats_t(data);
+}
+
+void equilibrate(ProblemData &data) {
+	equilibrate_t(data);
+}
+
+void equilibrate(ProblemDataFloat &data) {
+	equilibrate_t(data);
+}
@@ -0,0 +1,44 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Passes that transform the ProblemData returned by build_matrix.
+
+#ifndef PROBLEMDATAOPERATIONS_H
+#define PROBLEMDATAOPERATIONS_H
+
+#include "ProblemData.hpp"
+
+/* Sums duplicate (I, J) entries, drops entries with |v| <= ZERO_TOL and
+ * sorts V, I, J by column, then row (CSC order). Duplicates are summed in
+ * double precision. */
+void canonicalize(ProblemData &data, double zero_tol);
+void canonicalize(ProblemDataFloat &data, double zero_tol);
+
+/* Fills DATA.stats with the row and column norms and nonzero counts of the
+ * matrix as currently stored. Duplicate entries count separately, so call
+ * canonicalize first for exact norms. */
+void compute_stats(ProblemData &data);
+void compute_stats(ProblemDataFloat &data);
+
+/* One step of Ruiz equilibration: scales row i by 1 / sqrt(|A_i|_inf) and
+ * column j by 1 / sqrt(|A^j|_inf), in place, and scales the constant vector
+ * by the same row factors. Empty rows and columns are left unscaled.
+ *
+ * Afterwards DATA.stats describes the matrix before scaling and holds the
+ * total scaling in row_scale and col_scale; repeated calls compose. */
+void equilibrate(ProblemData &data);
+void equilibrate(ProblemDataFloat &data);
+
+#endif
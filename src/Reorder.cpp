@@ -0,0 +1,244 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Reorder.hpp"
+#include "ProblemDataOperations.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+/**
+ * Returns the entries of each row: the columns of row i are
+ * ROW_COLS[ROW_START[i]] ... ROW_COLS[ROW_START[i + 1] - 1].
+ */
+template <typename Scalar>
+static void get_row_lists(const ProblemDataT<Scalar> &data, int num_rows,
+                          std::vector<long> &row_start,
+                          std::vector<int> &row_cols) {
+	long nnz = data.V.size();
+	row_start.assign(num_rows + 1, 0);
+	for (long k = 0; k < nnz; k++) {
+		row_start[data.I[k] + 1]++;
+	}
+	for (int i = 0; i < num_rows; i++) {
+		row_start[i + 1] += row_start[i];
+	}
+	row_cols.resize(nnz);
+	std::vector<long> next(row_start.begin(), row_start.end() - 1);
+	for (long k = 0; k < nnz; k++) {
+		row_cols[next[data.I[k]]++] = data.J[k];
+	}
+}
+
+/**
+ * Reverse Cuthill-McKee ordering of the columns. Two columns are adjacent
+ * in A^T A if they share a row, so the breadth first search steps from a
+ * column through its rows to their columns. Each row is expanded once,
+ * which keeps the search O(nnz) even with dense rows.
+ *
+ * The degree of a column is approximated by the total length of its rows.
+ * Each connected component starts from its unvisited column of smallest
+ * degree.
+ */
+template <typename Scalar>
+static std::vector<int> rcm_order(const ProblemDataT<Scalar> &data,
+                                  int num_rows, int num_cols) {
+	std::vector<long> row_start;
+	std::vector<int> row_cols;
+	get_row_lists(data, num_rows, row_start, row_cols);
+
+	/* Columns of canonicalized data are contiguous */
+	long nnz = data.V.size();
+	std::vector<long> col_start(num_cols + 1, 0);
+	for (long k = 0; k < nnz; k++) {
+		col_start[data.J[k] + 1]++;
+	}
+	for (int j = 0; j < num_cols; j++) {
+		col_start[j + 1] += col_start[j];
+	}
+
+	std::vector<long> degree(num_cols, 0);
+	for (long k = 0; k < nnz; k++) {
+		int row = data.I[k];
+		degree[data.J[k]] += row_start[row + 1] - row_start[row] - 1;
+	}
+	std::vector<int> by_degree(num_cols);
+	for (int j = 0; j < num_cols; j++) {
+		by_degree[j] = j;
+	}
+	std::stable_sort(by_degree.begin(), by_degree.end(),
+	                 [&degree](int a, int b) { return degree[a] < degree[b]; });
+
+	std::vector<bool> col_seen(num_cols, false);
+	std::vector<bool> row_done(num_rows, false);
+	std::vector<int> order;
+	order.reserve(num_cols);
+	for (int s = 0; s < num_cols; s++) {
+		int start = by_degree[s];
+		if (col_seen[start]) {
+			continue;
+		}
+		col_seen[start] = true;
+		unsigned head = order.size();
+		order.push_back(start);
+		while (head < order.size()) {
+			int col = order[head++];
+			unsigned first_new = order.size();
+			for (long k = col_start[col]; k < col_start[col + 1]; k++) {
+				int row = data.I[k];
+				if (row_done[row]) {
+					continue;
+				}
+				row_done[row] = true;
+				for (long p = row_start[row]; p < row_start[row + 1]; p++) {
+					if (!col_seen[row_cols[p]]) {
+						col_seen[row_cols[p]] = true;
+						order.push_back(row_cols[p]);
+					}
+				}
+			}
+			std::stable_sort(order.begin() + first_new, order.end(),
+			                 [&degree](int a, int b) {
+			                 	return degree[a] < degree[b];
+			                 });
+		}
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+/**
+ * COLAMD ordering of the columns, from the bundled Eigen.
+ */
+template <typename Scalar>
+static std::vector<int> colamd_order(const ProblemDataT<Scalar> &data,
+                                     int num_rows, int num_cols) {
+	std::vector<Triplet> pattern;
+	pattern.reserve(data.V.size());
+	for (unsigned k = 0; k < data.V.size(); k++) {
+		pattern.push_back(Triplet(data.I[k], data.J[k], 1.0));
+	}
+	Matrix mat(num_rows, num_cols);
+	mat.setFromTriplets(pattern.begin(), pattern.end());
+	mat.makeCompressed();
+
+	Eigen::COLAMDOrdering<int> colamd;
+	Eigen::COLAMDOrdering<int>::PermutationType perm;
+	colamd(mat, perm);
+
+	/* PERM maps original columns to new positions */
+	std::vector<int> order(num_cols);
+	for (int j = 0; j < num_cols; j++) {
+		order[perm.indices()(j)] = j;
+	}
+	return order;
+}
+
+/**
+ * Implementation of reorder for either precision.
+ */
+template <typename Scalar>
+static Reordering reorder_t(ProblemDataT<Scalar> &data, int num_zero_rows,
+                            int num_nonneg_rows, int num_cols,
+                            ReorderMethod method) {
+	data.densify_const_vec();
+	int num_rows = data.const_vec.size();
+	int num_reducible = num_zero_rows + num_nonneg_rows;
+	if (num_zero_rows < 0 || num_nonneg_rows < 0 || num_reducible > num_rows) {
+		std::cerr << "Error: reorder row sections exceed the number of rows"
+		          << std::endl;
+		exit(-1);
+	}
+
+	canonicalize(data, 0);
+	if (!data.J.empty()) {
+		num_cols = std::max(num_cols, data.J.back() + 1);
+	}
+	num_cols = std::max(num_cols, (int) data.obj_vec.size());
+
+	Reordering result;
+	if (method == REORDER_RCM) {
+		result.col_perm = rcm_order(data, num_rows, num_cols);
+	} else if (method == REORDER_COLAMD) {
+		result.col_perm = colamd_order(data, num_rows, num_cols);
+	} else {
+		std::cerr << "Error: unknown reorder method" << std::endl;
+		exit(-1);
+	}
+	std::vector<int> new_col(num_cols);
+	for (int j = 0; j < num_cols; j++) {
+		new_col[result.col_perm[j]] = j;
+	}
+
+	/* Within each section, sort rows by their first new column. Empty rows
+	   go last. */
+	std::vector<int> first_col(num_rows, num_cols);
+	for (unsigned k = 0; k < data.V.size(); k++) {
+		int row = data.I[k];
+		first_col[row] = std::min(first_col[row], new_col[data.J[k]]);
+	}
+	result.row_perm.resize(num_rows);
+	for (int i = 0; i < num_rows; i++) {
+		result.row_perm[i] = i;
+	}
+	std::vector<int>::iterator zero_end = result.row_perm.begin() + num_zero_rows;
+	std::vector<int>::iterator nonneg_end = zero_end + num_nonneg_rows;
+	auto by_first_col = [&first_col](int a, int b) {
+		return first_col[a] < first_col[b];
+	};
+	std::stable_sort(result.row_perm.begin(), zero_end, by_first_col);
+	std::stable_sort(zero_end, nonneg_end, by_first_col);
+	std::vector<int> new_row(num_rows);
+	for (int i = 0; i < num_rows; i++) {
+		new_row[result.row_perm[i]] = i;
+	}
+
+	for (unsigned k = 0; k < data.V.size(); k++) {
+		data.I[k] = new_row[data.I[k]];
+		data.J[k] = new_col[data.J[k]];
+	}
+	std::vector<Scalar> const_vec(num_rows);
+	for (int i = 0; i < num_rows; i++) {
+		const_vec[i] = data.const_vec[result.row_perm[i]];
+	}
+	data.const_vec.swap(const_vec);
+	if (!data.obj_vec.empty()) {
+		std::vector<Scalar> obj_vec(num_cols, 0);
+		for (unsigned j = 0; j < data.obj_vec.size(); j++) {
+			obj_vec[new_col[j]] = data.obj_vec[j];
+		}
+		data.obj_vec.swap(obj_vec);
+	}
+	canonicalize(data, 0);
+	data.stats = MatrixStats();
+	return result;
+}
+
+/***************************
+ * REORDER
+ ***************************/
+
+Reordering reorder(ProblemData &data, int num_zero_rows, int num_nonneg_rows,
+                   int num_cols, ReorderMethod method) {
+	return reorder_t(data, num_zero_rows, num_nonneg_rows, num_cols, method);
+}
+
+Reordering reorder(ProblemDataFloat &data, int num_zero_rows,
+                   int num_nonneg_rows, int num_cols, ReorderMethod method) {
+	return reorder_t(data, num_zero_rows, num_nonneg_rows, num_cols, method);
+}
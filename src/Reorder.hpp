@@ -0,0 +1,65 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Row and column reordering of the ProblemData returned by build_matrix.
+
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "ProblemData.hpp"
+#include <vector>
+
+enum ReorderMethod {
+	/* Reverse Cuthill-McKee on the column graph of A^T A, which narrows
+	 * the bandwidth and improves locality */
+	REORDER_RCM,
+	/* Column approximate minimum degree (COLAMD) on A, a fill-reducing
+	 * ordering for factorizations of A^T A and the KKT system */
+	REORDER_COLAMD
+};
+
+/* Permutations applied by REORDER. Row i of the reordered problem is
+ * original row ROW_PERM[i], and column j is original column COL_PERM[j]. */
+class Reordering {
+public:
+	std::vector<int> row_perm;
+	std::vector<int> col_perm;
+
+	/* Maps a solution X of the reordered problem to the original columns */
+	std::vector<double> restore_cols(const std::vector<double> &x) const {
+		std::vector<double> result(x.size());
+		for (unsigned j = 0; j < x.size(); j++) {
+			result[col_perm[j]] = x[j];
+		}
+		return result;
+	}
+};
+
+/* Permutes the columns of DATA with METHOD and then the rows so that each
+ * row sits near its first column, in place. Rows are only moved within the
+ * leading NUM_ZERO_ROWS and the following NUM_NONNEG_ROWS rows (see
+ * Presolve.hpp), so the rows of every other cone keep their positions.
+ *
+ * A sparse constant vector is densified first. DATA is canonicalized before
+ * and after, and OBJ_VEC is permuted with the columns; id_to_col and
+ * const_to_row still refer to the original columns and rows. NUM_COLS is
+ * the number of columns of the matrix, or -1 to use one past the largest
+ * column index. */
+Reordering reorder(ProblemData &data, int num_zero_rows, int num_nonneg_rows,
+                   int num_cols, ReorderMethod method);
+Reordering reorder(ProblemDataFloat &data, int num_zero_rows,
+                   int num_nonneg_rows, int num_cols, ReorderMethod method);
+
+#endif
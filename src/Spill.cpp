@@ -0,0 +1,126 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Spill.hpp"
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+std::string get_spill_dir(const std::string &dir) {
+	if (!dir.empty()) {
+		return dir;
+	}
+	const char *tmpdir = getenv("TMPDIR");
+	if (tmpdir != NULL && tmpdir[0] != '\0') {
+		return tmpdir;
+	}
+	return "/tmp";
+}
+
+#ifndef _WIN32
+/* Creates and unlinks a temporary file in DIR. Returns its descriptor, or
+	 -1 on failure. */
+static int open_temp_fd(const std::string &dir) {
+	std::string path = dir + "/cvxcanon-XXXXXX";
+	std::vector<char> name(path.begin(), path.end());
+	name.push_back('\0');
+	int fd = mkstemp(&name[0]);
+	if (fd >= 0) {
+		unlink(&name[0]);
+	}
+	return fd;
+}
+
+FILE *open_spill_file(const std::string &dir) {
+	int fd = open_temp_fd(dir);
+	FILE *file = fd < 0 ? NULL : fdopen(fd, "w+b");
+	if (file == NULL) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		throw std::runtime_error("could not create a temporary file in " + dir);
+	}
+	return file;
+}
+
+/* Allocates the blocks of the first BYTES bytes of the file FD, so writes
+	 through a shared mapping of it cannot run out of disk space, which would
+	 raise SIGBUS. Returns false if there is not enough space. */
+static bool reserve_file(int fd, size_t bytes) {
+#ifdef __APPLE__
+	/* No posix_fallocate; F_PREALLOCATE only reserves, so the file is then
+		 extended to its size */
+	fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t) bytes, 0};
+	if (fcntl(fd, F_PREALLOCATE, &store) != 0) {
+		return false;
+	}
+	return ftruncate(fd, bytes) == 0;
+#else
+	return posix_fallocate(fd, 0, bytes) == 0;
+#endif
+}
+#else
+FILE *open_spill_file(const std::string &dir) {
+	FILE *file = tmpfile();
+	if (file == NULL) {
+		throw std::runtime_error("could not create a temporary file");
+	}
+	return file;
+}
+#endif
+
+FileResource::FileResource(const std::string &dir, size_t min_bytes)
+	: dir(get_spill_dir(dir)), min_bytes(min_bytes) {}
+
+#ifndef _WIN32
+void *FileResource::allocate(size_t bytes) {
+	if (bytes < min_bytes) {
+		return ::operator new(bytes);
+	}
+	int fd = open_temp_fd(dir);
+	if (fd < 0) {
+		throw std::bad_alloc();
+	}
+	void *map = MAP_FAILED;
+	if (reserve_file(fd, bytes)) {
+		map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	/* The mapping keeps the file alive */
+	close(fd);
+	if (map == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+	return map;
+}
+
+void FileResource::deallocate(void *ptr, size_t bytes) {
+	if (bytes < min_bytes) {
+		::operator delete(ptr);
+		return;
+	}
+	munmap(ptr, bytes);
+}
+#else
+void *FileResource::allocate(size_t bytes) {
+	return ::operator new(bytes);
+}
+
+void FileResource::deallocate(void *ptr, size_t) {
+	::operator delete(ptr);
+}
+#endif
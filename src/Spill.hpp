@@ -0,0 +1,172 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+// Temporary files for builds with a memory budget, see
+// BuildOptions::memory_budget.
+
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "MemoryResource.hpp"
+
+/* Returns DIR, or if it is empty the directory named by $TMPDIR, or /tmp */
+std::string get_spill_dir(const std::string &dir);
+
+/* Opens a new temporary file in DIR for reading and writing. The file is
+ * removed from DIR right away, so it goes away with the last handle even if
+ * the process is killed. Throws std::runtime_error on failure. */
+FILE *open_spill_file(const std::string &dir);
+
+/* Maps buffers of at least MIN_BYTES bytes from temporary files in DIR,
+ * so the kernel can write their pages back to disk and drop them instead
+ * of keeping the whole buffer in RAM. Smaller buffers come from operator
+ * new. The disk space of a file is allocated up front, and ALLOCATE throws
+ * std::bad_alloc if DIR does not have room for it. On systems without mmap
+ * this is the same as NewDeleteResource. */
+class FileResource : public MemoryResource {
+public:
+	FileResource(const std::string &dir, size_t min_bytes);
+
+	void *allocate(size_t bytes);
+	void deallocate(void *ptr, size_t bytes);
+
+private:
+	std::string dir;
+	size_t min_bytes;
+};
+
+/* Writes the V, I and J entries of a build to a temporary file whenever
+ * more than BUDGET bytes of them are held in memory, and at the end of the
+ * build reads them back in their original order into buffers mapped from
+ * other temporary files, see FileResource. The spill file holds one block
+ * per spill: the values, then the row indices, then the column indices of
+ * the block, as raw arrays. The block lengths are kept in memory. Throws
+ * std::runtime_error if the file cannot be written or read back. */
+class TripletSpill {
+public:
+	TripletSpill(const std::string &dir, long budget)
+		: dir(get_spill_dir(dir)), budget(budget), file(NULL), spilled(0) {}
+
+	~TripletSpill() {
+		if (file != NULL) {
+			fclose(file);
+		}
+	}
+
+	/* Moves V, I and J to the file if they take more than the budget. The
+		 vectors keep their capacity for the next entries. */
+	template <typename Scalar>
+	void spill_if_over_budget(Buffer<Scalar> &V, Buffer<int> &I,
+	                          Buffer<int> &J) {
+		if ((long) (V.size() * entry_bytes<Scalar>()) <= budget) {
+			return;
+		}
+		if (file == NULL) {
+			file = open_spill_file(dir);
+		}
+		write_array(V);
+		write_array(I);
+		write_array(J);
+		blocks.push_back(V.size());
+		spilled += V.size();
+		V.clear();
+		I.clear();
+		J.clear();
+	}
+
+	/* Puts the spilled entries back in front of V, I and J. Since they did
+		 not fit the budget, the result is mapped from a temporary file. Returns
+		 false, and leaves V, I and J alone, if nothing was spilled. */
+	template <typename Scalar>
+	bool unspill(Buffer<Scalar> &V, Buffer<int> &I, Buffer<int> &J) {
+		if (blocks.empty()) {
+			return false;
+		}
+		size_t nnz = spilled + V.size();
+		std::shared_ptr<MemoryResource> resource(
+			new FileResource(dir, PAGE_RESOURCE_MIN_BYTES));
+		Buffer<Scalar> all_V((ResourceAllocator<Scalar>(resource)));
+		Buffer<int> all_I((ResourceAllocator<int>(resource)));
+		Buffer<int> all_J((ResourceAllocator<int>(resource)));
+		all_V.reserve(nnz);
+		all_I.reserve(nnz);
+		all_J.reserve(nnz);
+
+		/* Blocks are read back one at a time */
+		rewind(file);
+		for (unsigned b = 0; b < blocks.size(); b++) {
+			read_array(all_V, blocks[b]);
+			read_array(all_I, blocks[b]);
+			read_array(all_J, blocks[b]);
+		}
+		fclose(file);
+		file = NULL;
+		blocks.clear();
+		spilled = 0;
+
+		all_V.insert(all_V.end(), V.begin(), V.end());
+		all_I.insert(all_I.end(), I.begin(), I.end());
+		all_J.insert(all_J.end(), J.begin(), J.end());
+		V.swap(all_V);
+		I.swap(all_I);
+		J.swap(all_J);
+		return true;
+	}
+
+	/* Directory of the temporary files */
+	const std::string &get_dir() const {
+		return dir;
+	}
+
+private:
+	std::string dir;
+	long budget;
+	FILE *file;
+	std::vector<size_t> blocks;
+	long spilled;
+
+	template <typename Scalar>
+	static size_t entry_bytes() {
+		return sizeof(Scalar) + 2 * sizeof(int);
+	}
+
+	template <typename T>
+	void write_array(Buffer<T> &array) {
+		if (fwrite(array.data(), sizeof(T), array.size(), file) != array.size()) {
+			throw std::runtime_error("could not write to a temporary file in " +
+			                         dir);
+		}
+	}
+
+	/* Appends the next LENGTH entries of the file to ARRAY */
+	template <typename T>
+	void read_array(Buffer<T> &array, size_t length) {
+		size_t start = array.size();
+		array.resize(start + length);
+		if (fread(array.data() + start, sizeof(T), length, file) != length) {
+			throw std::runtime_error("could not read a temporary file in " + dir);
+		}
+	}
+
+	TripletSpill(const TripletSpill &);
+	TripletSpill &operator=(const TripletSpill &);
+};
+
+#endif
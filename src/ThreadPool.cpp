@@ -0,0 +1,113 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPool.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* Restricts the calling thread to the CPUS listed, if it can */
+static void set_affinity(const std::vector<int> &cpus) {
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (unsigned i = 0; i < cpus.size(); i++) {
+		if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+			CPU_SET(cpus[i], &set);
+		}
+	}
+	if (CPU_COUNT(&set) > 0) {
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#endif
+}
+
+ThreadPool::ThreadPool(int num_threads, const std::vector<int> &cpus,
+                       bool pin_threads)
+	: spare(0), num_threads(num_threads > 0 ? num_threads : 1),
+	  stopping(false) {
+	spare = this->num_threads - 1;
+	for (int t = 0; t < this->num_threads - 1; t++) {
+		std::vector<int> allowed = cpus;
+		if (pin_threads && !cpus.empty()) {
+			allowed.assign(1, cpus[t % cpus.size()]);
+		}
+		workers.push_back(std::thread([this, allowed]() {
+			if (!allowed.empty()) {
+				set_affinity(allowed);
+			}
+			current_pool() = this;
+			work_loop();
+		}));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	job_ready.notify_all();
+	for (unsigned i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+void ThreadPool::work_loop() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (jobs.empty() && !stopping) {
+				job_ready.wait(lock);
+			}
+			if (jobs.empty()) {
+				return;
+			}
+			job = jobs.front();
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void ThreadPool::run(int num_workers, const std::function<void()> &work) {
+	if (num_workers <= 0) {
+		work();
+		return;
+	}
+	std::mutex done_mutex;
+	std::condition_variable done;
+	int pending = num_workers;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int t = 0; t < num_workers; t++) {
+			jobs.push_back([&]() {
+				work();
+				std::lock_guard<std::mutex> done_lock(done_mutex);
+				if (--pending == 0) {
+					done.notify_one();
+				}
+			});
+		}
+	}
+	job_ready.notify_all();
+	work();
+	std::unique_lock<std::mutex> lock(done_mutex);
+	while (pending > 0) {
+		done.wait(lock);
+	}
+}
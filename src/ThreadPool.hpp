@@ -0,0 +1,76 @@
+//    This file is part of CVXcanon.
+//
+//    CVXcanon is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    CVXcanon is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Worker threads that are started once and reused by every parallel loop
+ * run while the pool is current, see current_pool() and Parallel.hpp.
+ *
+ * A pool of NUM_THREADS threads starts NUM_THREADS - 1 workers; the thread
+ * that runs a parallel loop always does its share of the work. */
+class ThreadPool {
+public:
+	/* Workers that are not reserved by a running task set. Used instead of
+	 * the global count in Parallel.hpp while the pool is current. */
+	std::atomic<int> spare;
+
+	/* If CPUS is not empty the workers only run on those CPUs: worker T is
+	 * pinned to CPUS[T % CPUS.size()] if PIN_THREADS is set, and may run on
+	 * any of them otherwise. */
+	ThreadPool(int num_threads, const std::vector<int> &cpus, bool pin_threads);
+	~ThreadPool();
+
+	/* Number of threads, counting the one that runs a parallel loop */
+	int size() const {
+		return num_threads;
+	}
+
+	/* Runs WORK on NUM_WORKERS workers and on the calling thread, and
+	 * returns once every copy has finished. NUM_WORKERS must have been
+	 * reserved from SPARE, so that the workers are free to take the work. */
+	void run(int num_workers, const std::function<void()> &work);
+
+private:
+	int num_threads;
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()> > jobs;
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	bool stopping;
+
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	void work_loop();
+};
+
+/* Pool used by the parallel loops on this thread, or NULL to use the shared
+ * pool of Parallel.hpp. Set on the workers of a pool, and by ContextScope in
+ * ExecutionContext.hpp. */
+inline ThreadPool *&current_pool() {
+	static thread_local ThreadPool *pool = NULL;
+	return pool;
+}
+
+#endif
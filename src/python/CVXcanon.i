@@ -17,18 +17,51 @@
 
 %{
 	#define SWIG_FILE_WITH_INIT
+	#include <new>
+	#include <stdexcept>
 	#include "CVXcanon.hpp"
+	#include "ProblemDataOperations.hpp"
+	#include "Presolve.hpp"
+	#include "Reorder.hpp"
+	#include "ExecutionContext.hpp"
 %}
 
 %include "numpy.i"
 %include "std_vector.i"
 %include "std_map.i"
+%include "std_string.i"
+
+/* Useful wrappers for the LinOp and ProblemData classes. They must precede
+	 the headers that use them, so their members get the proxy classes. */
+namespace std {
+   %template(IntVector) vector<int>;
+   %template(DoubleVector) vector<double>;
+   %template(FloatVector) vector<float>;
+   %template(IntVector2D) vector< vector<int> >;
+   %template(DoubleVector2D) vector< vector<double> >;
+   %template(IntIntMap) map<int, int>;
+}
 
 /* Must call this before using NUMPY-C API */
 %init %{
 	import_array();
 %}
 
+/* C++ exceptions, such as the I/O errors of builds that spill to disk, are
+	 raised as Python exceptions instead of terminating the interpreter */
+%include "exception.i"
+%exception {
+	try {
+		$action
+	} catch (const std::bad_alloc &) {
+		SWIG_exception(SWIG_MemoryError, "out of memory");
+	} catch (const std::invalid_argument &e) {
+		SWIG_exception(SWIG_ValueError, e.what());
+	} catch (const std::exception &e) {
+		SWIG_exception(SWIG_RuntimeError, e.what());
+	}
+}
+
 /* Typemap for the addDenseData C++ routine in LinOp.hpp */
 %apply (double* IN_FARRAY2, int DIM1, int DIM2) {(double* matrix, int rows, int cols)};
 
@@ -37,23 +70,274 @@
 	(double *row_idxs, int rows_len),
 	(double *col_idxs, int cols_len)};
 
+/* Typemap for the set_sparse_csc C++ routine in LinOp.hpp */
+%apply (double* IN_ARRAY1, int DIM1) {(double *csc_data, int csc_data_len)};
+%apply (int* IN_ARRAY1, int DIM1) {(int *csc_indices, int csc_indices_len),
+	(int *csc_indptr, int csc_indptr_len)};
+
+/* Typemaps for the zero-copy views used by pickling in LinOp.hpp and
+	 ProblemData.hpp */
+%apply (double** ARGOUTVIEW_FARRAY2, int* DIM1, int* DIM2) {(double** view_data, int* view_rows, int* view_cols)};
+%apply (double** ARGOUTVIEW_ARRAY1, int* DIM1) {(double** view_data, int* view_len)};
+%apply (float** ARGOUTVIEW_ARRAY1, int* DIM1) {(float** view_data, int* view_len)};
+%apply (int** ARGOUTVIEW_ARRAY1, int* DIM1) {(int** idx_view, int* idx_len)};
+
 %include "LinOp.hpp"
 
+namespace std {
+   %template(LinOpVector) vector< LinOp * >;
+}
+
 /* Typemap for the getV, getI, getJ, and getConstVec C++ routines in 
 	 problemData.hpp */
 %apply (double* ARGOUT_ARRAY1, int DIM1) {(double* values, int num_values)}
+%apply (float* ARGOUT_ARRAY1, int DIM1) {(float* values, int num_values)}
+
+/* Typemaps for the setV, setI, setJ, and setConstVec C++ routines in
+	 problemData.hpp */
+%apply (double* IN_ARRAY1, int DIM1) {(double* in_data, int in_len)};
+%apply (float* IN_ARRAY1, int DIM1) {(float* in_data, int in_len)};
+%apply (int* IN_ARRAY1, int DIM1) {(int* in_idxs, int in_len)};
 %include "ProblemData.hpp"
 
-/* Useful wrappers for the LinOp class */
-namespace std {
-   %template(IntVector) vector<int>;
-   %template(DoubleVector) vector<double>;
-   %template(IntVector2D) vector< vector<int> >;
-   %template(DoubleVector2D) vector< vector<double> >;
-   %template(IntIntMap) map<int, int>;
-   %template(LinOpVector) vector< LinOp * >;
+/* Pickle support for both instantiations of the problem data classes, see
+	 below. Must precede %template. */
+%extend ProblemDataT {
+%pythoncode %{
+    def __reduce_ex__(self, protocol):
+        return _reduce_problem_data(self, protocol)
+%}
+}
+
+%extend ConeProblemDataT {
+%pythoncode %{
+    def __reduce_ex__(self, protocol):
+        return _reduce_cone_problem_data(self, protocol)
+%}
 }
 
+%template(ProblemData) ProblemDataT<double>;
+%template(ProblemDataFloat) ProblemDataT<float>;
+%template(ConeProblemData) ConeProblemDataT<double>;
+%template(ConeProblemDataFloat) ConeProblemDataT<float>;
+
+
+%include "BuildOptions.hpp"
+%include "ExecutionContext.hpp"
+
 /* Wrapper for entry point into CVXCanon Library */
 ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col);
 ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets);
+ProblemData build_matrix(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemData build_matrix(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options);
+ProblemData build_matrix(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options, ExecutionContext *context);
+ProblemDataFloat build_matrix_float(std::vector< LinOp* > constraints, LinOp *objective, std::map<int, int> id_to_col, std::vector<int> constr_offsets, BuildOptions options, ExecutionContext *context);
+ConeProblemData build_cone_matrix(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options);
+ConeProblemDataFloat build_cone_matrix_float(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options);
+ConeProblemData build_cone_matrix(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options, ExecutionContext *context);
+ConeProblemDataFloat build_cone_matrix_float(std::vector< LinOp* > constraints, std::vector<int> cone_types, std::map<int, int> id_to_col, BuildOptions options, ExecutionContext *context);
+QuadProblemData build_quad_matrix(std::vector< LinOp* > quad_terms, std::map<int, int> id_to_col, int num_cols);
+
+/* Passes over the problem data */
+%include "ProblemDataOperations.hpp"
+%include "Presolve.hpp"
+%include "Reorder.hpp"
+
+/* Pickle support. Under protocol 5 the numeric payloads are exported as
+	 PickleBuffers over views of the C++ data, so they can be sent
+	 out-of-band without copying. Older protocols copy them in-band. */
+%extend LinOp {
+%pythoncode %{
+    def __reduce_ex__(self, protocol):
+        return _reduce_lin_op(self, protocol)
+%}
+}
+
+%pythoncode %{
+import pickle as _pickle
+import numpy as _np
+
+
+class _OwnedView(_np.ndarray):
+    '''An ndarray view of C++ memory which keeps the owning SWIG object
+    alive for as long as the view (or a PickleBuffer over it) exists.'''
+    pass
+
+
+def _export(view, owner, protocol):
+    if protocol >= 5 and hasattr(_pickle, 'PickleBuffer'):
+        view = view.view(_OwnedView)
+        view._owner = owner
+        return _pickle.PickleBuffer(view)
+    return _np.array(view)
+
+
+def _import(buf, dtype):
+    return _np.frombuffer(buf, dtype=dtype)
+
+
+def _reduce_problem_data(prob, protocol, owner=None):
+    '''OWNER keeps the memory of PROB alive, if PROB is a member of it.'''
+    if owner is None:
+        owner = prob
+    payload = (type(prob),
+               _export(prob.viewV(), owner, protocol),
+               _export(prob.viewI(), owner, protocol),
+               _export(prob.viewJ(), owner, protocol),
+               _export(prob.viewConstVec(), owner, protocol),
+               dict(prob.id_to_col.items()),
+               dict(prob.const_to_row.items()),
+               _export(prob.viewObjVec(), owner, protocol),
+               float(prob.obj_offset),
+               _reduce_sparse_const(prob, owner, protocol),
+               _reduce_stats(prob, owner, protocol))
+    return (_rebuild_problem_data, payload)
+
+
+# Fields of MatrixStats, in the order of MatrixStats::viewNorms and
+# MatrixStats::viewCounts
+_STATS_NORMS = ('row_norm_inf', 'row_norm_two', 'col_norm_inf',
+                'col_norm_two', 'row_scale', 'col_scale')
+_STATS_COUNTS = ('row_nnz', 'col_nnz')
+
+
+def _reduce_stats(prob, owner, protocol):
+    stats = prob.stats
+    return (tuple(_export(stats.viewNorms(k), owner, protocol)
+                  for k in range(len(_STATS_NORMS))),
+            tuple(_export(stats.viewCounts(k), owner, protocol)
+                  for k in range(len(_STATS_COUNTS))))
+
+
+def _load_stats(prob, stats):
+    norms, counts = stats
+    for k, values in enumerate(norms):
+        prob.stats.setNorms(k, _import(values, _np.float64))
+    for k, values in enumerate(counts):
+        prob.stats.setCounts(k, _import(values, _np.intc))
+
+
+def _load_int_map(cmap, pymap):
+    for key, val in pymap.items():
+        cmap[int(key)] = int(val)
+
+
+def _reduce_sparse_const(prob, owner, protocol):
+    if not prob.sparse_const:
+        return None
+    return (prob.const_len, _export(prob.viewConstIdx(), owner, protocol),
+            _export(prob.viewConstVal(), owner, protocol))
+
+
+def _rebuild_problem_data(cls, V, I, J, const_vec, id_to_col, const_to_row,
+                          obj_vec=None, obj_offset=0.0, sparse_const=None,
+                          stats=None):
+    prob = cls()
+    dtype = _np.float32 if cls is ProblemDataFloat else _np.float64
+    prob.setV(_import(V, dtype))
+    prob.setI(_import(I, _np.intc))
+    prob.setJ(_import(J, _np.intc))
+    prob.setConstVec(_import(const_vec, dtype))
+    if obj_vec is not None:
+        prob.setObjVec(_import(obj_vec, dtype))
+    prob.obj_offset = obj_offset
+    if sparse_const is not None:
+        prob.sparse_const = True
+        prob.const_len, idx, val = sparse_const
+        prob.setConstIdx(_import(idx, _np.intc))
+        prob.setConstVal(_import(val, dtype))
+    if stats is not None:
+        _load_stats(prob, stats)
+    _load_int_map(prob.id_to_col, id_to_col)
+    _load_int_map(prob.const_to_row, const_to_row)
+    return prob
+
+
+def _reduce_cone_problem_data(cone, protocol):
+    '''Both blocks are exported with CONE as the owner of their memory.'''
+    payload = (type(cone),
+               _reduce_problem_data(cone.eq, protocol, cone)[1],
+               _reduce_problem_data(cone.ineq, protocol, cone)[1],
+               list(cone.cone_rows),
+               [list(sizes) for sizes in cone.cone_sizes])
+    return (_rebuild_cone_problem_data, payload)
+
+
+def _rebuild_cone_problem_data(cls, eq, ineq, cone_rows, cone_sizes):
+    cone = cls()
+    cone.eq = _rebuild_problem_data(*eq)
+    cone.ineq = _rebuild_problem_data(*ineq)
+    for rows in cone_rows:
+        cone.cone_rows.push_back(int(rows))
+    for sizes in cone_sizes:
+        vec = IntVector()
+        for rows in sizes:
+            vec.push_back(int(rows))
+        cone.cone_sizes.push_back(vec)
+    return cone
+
+
+def _reduce_lin_op(root, protocol):
+    '''Flattens the tree rooted at ROOT breadth-first, so deep trees do not
+    hit the pickler's recursion limit. Nodes shared within the tree are
+    stored once.'''
+    index = {int(root.this): 0}
+    nodes = [root]
+    records = []
+    pos = 0
+    while pos < len(nodes):
+        lin = nodes[pos]
+        pos += 1
+        arg_idx = []
+        for arg in lin.args:
+            key = int(arg.this)
+            if key not in index:
+                index[key] = len(nodes)
+                nodes.append(arg)
+            arg_idx.append(index[key])
+        if lin.sparse:
+            data = (lin.sparse_data_rows(), lin.sparse_data_cols(),
+                    _export(lin.sparse_data_view(), lin, protocol),
+                    _export(lin.sparse_indices_view(), lin, protocol),
+                    _export(lin.sparse_indptr_view(), lin, protocol))
+        else:
+            dense = lin.dense_data_view()
+            data = (dense.shape[0], dense.shape[1],
+                    _export(dense.reshape(-1, order='F'), lin, protocol))
+        records.append((int(lin.type), tuple(lin.size), arg_idx,
+                        [tuple(sl) for sl in lin.slice], bool(lin.sparse),
+                        data))
+    return (_rebuild_lin_op, (records,))
+
+
+def _rebuild_lin_op(records):
+    nodes = [LinOp() for _ in records]
+    for lin, (ty, size, arg_idx, slices, sparse, data) in zip(nodes, records):
+        lin.type = ty
+        for dim in size:
+            lin.size.push_back(int(dim))
+        for idx in arg_idx:
+            lin.args.push_back(nodes[idx])
+        for sl in slices:
+            vec = IntVector()
+            for val in sl:
+                vec.push_back(int(val))
+            lin.slice.push_back(vec)
+        if sparse:
+            rows, cols, values, indices, indptr = data
+            lin.set_sparse_csc(_import(values, _np.float64),
+                               _import(indices, _np.intc),
+                               _import(indptr, _np.intc), rows, cols)
+        elif data[0] * data[1] > 0:
+            rows, cols, values = data
+            lin.set_dense_data(_import(values, _np.float64).reshape(
+                (rows, cols), order='F'))
+    # The C++ tree only holds raw pointers, so the root keeps the
+    # Python proxies of its descendants alive.
+    nodes[0]._tree_nodes = nodes[1:]
+    return nodes[0]
+%}
@@ -18,7 +18,11 @@ import numpy as np
 import scipy.sparse
 from collections import deque
 
-def get_problem_matrix(constrs, id_to_col=None, constr_offsets=None):
+def get_problem_matrix(constrs, id_to_col=None, constr_offsets=None,
+                       dtype=np.float64, canonicalize=False, zero_tol=0.0,
+                       stats=False, equilibrate=False, objective=None,
+                       sparse_const=False, context=None, memory_budget=0,
+                       spill_dir=""):
     '''
     Builds a sparse representation of the problem data by calling CVXCanon's
     C++ build_matrix function.
@@ -27,49 +31,246 @@ def get_problem_matrix(constrs, id_to_col=None, constr_offsets=None):
     ----------
         constrs: A list of python linOp trees
         id_to_col: A map from variable id to offset withoun our matrix
+        dtype: np.float64, or np.float32 to store V and const_vec in single
+               precision (coefficients are still computed in double)
+        canonicalize: if True, duplicate (I, J) entries are summed and the
+               entries are sorted by column, then row
+        zero_tol: with canonicalize, entries with |v| <= zero_tol are dropped
+        stats: if True, also return a dict of per row and per column
+               inf-norms, 2-norms and nonzero counts, computed while the
+               matrix is built
+        equilibrate: if True, apply one step of Ruiz equilibration to the
+               matrix and constant vector in place. The returned stats
+               describe the unscaled matrix and include the scaling
+        objective: a scalar python linOp tree c^T x + d. Its coefficients
+               are computed in the same pass as the constraints, sharing
+               their columns
+        sparse_const: if True, const_vec is built and returned as a
+               scipy.sparse.csc_matrix column, without ever allocating the
+               dense vector
+        context: a CVXcanon.ExecutionContext. Its worker threads are
+               reused across calls, and it sets the number of threads and
+               where they run, and with memory_policy (e.g.
+               CVXcanon.MEMORY_INTERLEAVE) and huge_pages where the pages
+               of V, I and J are placed
+        memory_budget: if positive, roughly the bytes of V, I and J kept in
+               memory during the build. Finished constraints beyond it are
+               spilled to temporary files in spill_dir ($TMPDIR or /tmp if
+               empty), and a matrix larger than the budget is returned from
+               memory mapped files
 
     Returns
     ----------
         V, I, J: numpy arrays encoding a sparse representation of our problem
         const_vec: a numpy column vector representing the constant_data in our problem
+        obj_vec, obj_offset: (only if objective is given) c as a numpy array
+               with one entry per column, and d as a float
+        stats: (only if stats is True) a dict of numpy arrays
+    '''
+    # tmp keeps the C++ trees in scope until build_matrix returns
+    lin_vec, tmp = load_constraints(constrs)
+    id_to_col_C = load_id_to_col(id_to_col)
+
+    if np.dtype(dtype) == np.float32:
+        build_matrix = CVXcanon.build_matrix_float
+    else:
+        build_matrix = CVXcanon.build_matrix
+
+    # Load constraint offsets into a C++ vector. An empty vector stacks
+    # the constraints in order
+    constr_offsets_C = CVXcanon.IntVector()
+    if constr_offsets is not None:
+        for offset in constr_offsets:
+            constr_offsets_C.push_back(int(offset))
+
+    options = CVXcanon.BuildOptions()
+    options.canonicalize = bool(canonicalize)
+    options.zero_tol = float(zero_tol)
+    options.compute_stats = bool(stats)
+    options.equilibrate = bool(equilibrate)
+    options.sparse_const_vec = bool(sparse_const)
+    options.memory_budget = int(memory_budget)
+    options.spill_dir = str(spill_dir)
+    if objective is not None:
+        obj_C = build_lin_op_tree(objective, tmp)
+    else:
+        obj_C = None
+    problemData = build_matrix(lin_vec, obj_C, id_to_col_C, constr_offsets_C,
+                               options, context)
+
+    result = list(unpack_matrix(problemData))
+    if objective is not None:
+        result.append(problemData.getObjVec(len(problemData.obj_vec)))
+        result.append(float(problemData.obj_offset))
+
+    if stats:
+        result.append(unpack_stats(problemData))
+
+    return tuple(result)
+
+
+def unpack_matrix(problemData):
+    '''Returns V, I, J and const_vec of the C++ PROBLEMDATA as numpy arrays,
+    with const_vec a column, or a scipy.sparse.csc_matrix column if it was
+    built sparse.'''
+    nnz = problemData.get_nnz()
+    V = problemData.getV(nnz)
+    I = problemData.getI(nnz)
+    J = problemData.getJ(nnz)
+    if problemData.sparse_const:
+        num_rows = problemData.get_num_rows()
+        idx = problemData.getConstIdx(len(problemData.const_idx))
+        val = problemData.getConstVal(len(problemData.const_val))
+        const_vec = scipy.sparse.csc_matrix(
+            (val, (idx.astype(np.int64), np.zeros(len(idx), dtype=np.int64))),
+            shape=(num_rows, 1))
+    else:
+        const_vec = problemData.getConstVec(len(problemData.const_vec))
+        const_vec = const_vec.reshape(-1, 1)
+    return V, I, J, const_vec
+
+
+def unpack_stats(problemData):
+    '''Returns the stats of the C++ PROBLEMDATA as a dict of numpy arrays'''
+    s = problemData.stats
+    fields = ['row_norm_inf', 'row_norm_two', 'row_nnz',
+              'col_norm_inf', 'col_norm_two', 'col_nnz',
+              'row_scale', 'col_scale']
+    return dict((f, np.array(getattr(s, f))) for f in fields)
+
+
+def get_cone_problem_matrix(constrs, cone_types, id_to_col=None,
+                            dtype=np.float64, canonicalize=False, zero_tol=0.0,
+                            stats=False, sparse_const=False, context=None,
+                            memory_budget=0, spill_dir=""):
+    '''
+    Builds the equality block (A, b) and the inequality block (G, h) of a
+    cone program in a single call to CVXCanon's C++ build_cone_matrix.
+
+    Parameters
+    ----------
+        constrs: A list of python linOp trees
+        cone_types: The cone of each constraint, one of CVXcanon.CONE_ZERO,
+               CONE_NONNEG, CONE_SOC, CONE_PSD and CONE_EXP. Constraints
+               with the same cone keep their relative order
+        id_to_col, dtype, canonicalize, zero_tol, stats, sparse_const,
+               context, memory_budget, spill_dir: see get_problem_matrix.
+               Each block gets half of memory_budget. Equilibration is not
+               supported, since both blocks must share their column scaling
+
+    Returns
+    ----------
+        (V, I, J, b): the zero cone rows, as returned by get_problem_matrix
+        (V, I, J, h): the rows of all other cones, ordered by cone type
+        cone_rows: a list with the number of rows of each cone type
+        cone_sizes: for each cone type, a list with the number of rows of
+               each of its constraints, in the order of their rows
+        (eq_stats, ineq_stats): (only if stats is True) the stats of each
+               block, as returned by get_problem_matrix
+    '''
+    if len(cone_types) != len(constrs):
+        raise ValueError("cone_types must have one entry per constraint")
+    for cone in cone_types:
+        if int(cone) != cone or not 0 <= cone < CVXcanon.NUM_CONE_TYPES:
+            raise ValueError("invalid cone type %r" % (cone,))
+
+    lin_vec, tmp = load_constraints(constrs)
+    id_to_col_C = load_id_to_col(id_to_col)
+    cone_types_C = CVXcanon.IntVector()
+    for cone in cone_types:
+        cone_types_C.push_back(int(cone))
+
+    if np.dtype(dtype) == np.float32:
+        build_cone_matrix = CVXcanon.build_cone_matrix_float
+    else:
+        build_cone_matrix = CVXcanon.build_cone_matrix
+
+    options = CVXcanon.BuildOptions()
+    options.canonicalize = bool(canonicalize)
+    options.zero_tol = float(zero_tol)
+    options.compute_stats = bool(stats)
+    options.sparse_const_vec = bool(sparse_const)
+    options.memory_budget = int(memory_budget)
+    options.spill_dir = str(spill_dir)
+    coneData = build_cone_matrix(lin_vec, cone_types_C, id_to_col_C, options,
+                                 context)
+
+    cone_sizes = [list(sizes) for sizes in coneData.cone_sizes]
+    result = [unpack_matrix(coneData.eq), unpack_matrix(coneData.ineq),
+              list(coneData.cone_rows), cone_sizes]
+    if stats:
+        result.append((unpack_stats(coneData.eq), unpack_stats(coneData.ineq)))
+    return tuple(result)
+
+
+def get_quad_problem_matrix(quad_terms, id_to_col=None, num_cols=0):
+    '''
+    Builds the quadratic objective (1/2) x^T P x + q^T x + r of a QP by
+    calling CVXCanon's C++ build_quad_matrix.
+
+    Parameters
+    ----------
+        quad_terms: A list of python linOp trees with type QUAD_FORM, whose
+               data Q is a constant with one row and column per entry of
+               its argument. The objective is the sum of arg^T Q arg
+        id_to_col: see get_problem_matrix. Variables that only appear in
+               the quadratic terms are given new columns
+        num_cols: the minimum number of columns of P, usually the number of
+               columns of the constraint matrix
+
+    Returns
+    ----------
+        P: the upper triangle of P as a scipy.sparse.csc_matrix
+        q: a numpy array
+        r: a float
+        id_to_col: a dict mapping variable ids to columns
     '''
-    linOps = [constr.expr for constr in constrs]
     lin_vec = CVXcanon.LinOpVector()
+    tmp = []
+    for term in quad_terms:
+        tree = build_lin_op_tree(term, tmp)
+        tmp.append(tree)
+        lin_vec.push_back(tree)
+    id_to_col_C = load_id_to_col(id_to_col)
 
-    id_to_col_C = CVXcanon.IntIntMap()
-    if id_to_col is None:
-        id_to_col = {}
+    quadData = CVXcanon.build_quad_matrix(lin_vec, id_to_col_C, int(num_cols))
+
+    n = quadData.num_cols
+    data = quadData.getPData(len(quadData.P_data))
+    indices = quadData.getPIndices(len(quadData.P_indices)).astype(np.int32)
+    indptr = quadData.getPIndptr(len(quadData.P_indptr)).astype(np.int32)
+    P = scipy.sparse.csc_matrix((data, indices, indptr), shape=(n, n))
+    q = quadData.getQ(len(quadData.q))
+    return P, q, quadData.r, dict(quadData.id_to_col.items())
 
-    # Loading the variable offsets from our
-    # Python map into a C++ map
-    for id, col in id_to_col.items():
-        id_to_col_C[int(id)] = int(col)
+
+def load_constraints(constrs):
+    '''
+    Converts the python constraints into a C++ LinOpVector. Returns the
+    vector and a list of the C++ trees, which must be kept alive while the
+    vector is in use.
+    '''
+    lin_vec = CVXcanon.LinOpVector()
 
     # This array keeps variables data in scope
     # after build_lin_op_tree returns
     tmp = []
-    for lin in linOps:
-        tree = build_lin_op_tree(lin, tmp)
+    for constr in constrs:
+        tree = build_lin_op_tree(constr.expr, tmp)
         tmp.append(tree)
         lin_vec.push_back(tree)
+    return lin_vec, tmp
 
-    if constr_offsets is None:
-        problemData = CVXcanon.build_matrix(lin_vec, id_to_col_C)
-    else:
-        # Load constraint offsets into a C++ vector
-        constr_offsets_C = CVXcanon.IntVector()
-        for offset in constr_offsets:
-            constr_offsets_C.push_back(int(offset))
-        problemData = CVXcanon.build_matrix(lin_vec, id_to_col_C,
-                                            constr_offsets_C)
-
-    # Unpacking
-    V = problemData.getV(len(problemData.V))
-    I = problemData.getI(len(problemData.I))
-    J = problemData.getJ(len(problemData.J))
-    const_vec = problemData.getConstVec(len(problemData.const_vec))
 
-    return V, I, J, const_vec.reshape(-1, 1)
+def load_id_to_col(id_to_col):
+    '''
+    Loads the variable offsets from a python dict (or None) into a C++ map.
+    '''
+    id_to_col_C = CVXcanon.IntIntMap()
+    if id_to_col is not None:
+        for id, col in id_to_col.items():
+            id_to_col_C[int(id)] = int(col)
+    return id_to_col_C
 
 
 def format_matrix(matrix, format='dense'):
@@ -177,7 +378,15 @@ type_map = {
     "DENSE_CONST": CVXcanon.DENSE_CONST,
     "SPARSE_CONST": CVXcanon.SPARSE_CONST,
     "NO_OP": CVXcanon.NO_OP,
-    "KRON": CVXcanon.KRON
+    "KRON": CVXcanon.KRON,
+    "SUM_AXIS": CVXcanon.SUM_AXIS,
+    "CUMSUM": CVXcanon.CUMSUM,
+    "DIFF": CVXcanon.DIFF,
+    "BLOCK_DIAG_MUL": CVXcanon.BLOCK_DIAG_MUL,
+    "SVEC": CVXcanon.SVEC,
+    "KRON_RIGHT": CVXcanon.KRON_RIGHT,
+    "CONV2D": CVXcanon.CONV2D,
+    "QUAD_FORM": CVXcanon.QUAD_FORM
 }
 
 
@@ -0,0 +1,175 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark for the C interface in CVXcanonC.h.
+ *
+ * Builds K dynamics-style constraints
+ *
+ *     A * x_k - x_{k+1} + b == 0,   k = 0, ..., K - 1
+ *
+ * with a dense N x N matrix A, and times cvxcanon_build followed by the
+ * size query and the copy into caller allocated buffers, once with double
+ * and once with single precision output.
+ *
+ * See tests/c/README for how to build it. Run it as
+ *
+ *     ./benchmark [N] [K] [REPEATS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "CVXcanonC.h"
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Times REPEATS builds of TREE in double (SINGLE = 0) or single precision
+ * and reports the size of the output buffers. */
+static void run(const cvxcanon_tree *tree, int K, const int *roots,
+                int repeats, int single) {
+	double build_time = 0, copy_time = 0;
+	int64_t nnz = 0;
+	int num_rows = 0, r;
+	size_t scalar = single ? sizeof(float) : sizeof(double);
+	for (r = 0; r < repeats; r++) {
+		cvxcanon_problem *prob;
+		double t0 = now();
+		int status = single
+		             ? cvxcanon_build_float(tree, K, roots, NULL, 0, NULL, NULL, &prob)
+		             : cvxcanon_build(tree, K, roots, NULL, 0, NULL, NULL, &prob);
+		if (status != CVXCANON_OK) {
+			fprintf(stderr, "cvxcanon_build failed\n");
+			exit(1);
+		}
+		double t1 = now();
+		cvxcanon_problem_size(prob, &nnz, &num_rows, NULL, NULL);
+		void *V = malloc(nnz * scalar);
+		int *I = malloc(nnz * sizeof(int));
+		int *J = malloc(nnz * sizeof(int));
+		void *b = malloc(num_rows * scalar);
+		if (single) {
+			cvxcanon_problem_copy_float(prob, V, I, J, b);
+		} else {
+			cvxcanon_problem_copy(prob, V, I, J, b);
+		}
+		double t2 = now();
+		build_time += t1 - t0;
+		copy_time += t2 - t1;
+		free(V);
+		free(I);
+		free(J);
+		free(b);
+		cvxcanon_problem_free(prob);
+	}
+	printf("%s: nnz = %ld, V + const_vec = %.1f MB\n",
+	       single ? "float " : "double", (long) nnz,
+	       (nnz + num_rows) * scalar / 1e6);
+	printf("        build: %.4f s, copy: %.4f s (mean of %d runs)\n",
+	       build_time / repeats, copy_time / repeats, repeats);
+}
+
+int main(int argc, char **argv) {
+	int n = argc > 1 ? atoi(argv[1]) : 200;
+	int K = argc > 2 ? atoi(argv[2]) : 50;
+	int repeats = argc > 3 ? atoi(argv[3]) : 5;
+
+	/* Nodes: K + 1 variables, then per constraint SUM, MUL, NEG, DENSE_CONST */
+	int num_nodes = (K + 1) + 4 * K;
+	int *type = malloc(num_nodes * sizeof(int));
+	int *size = malloc(2 * num_nodes * sizeof(int));
+	int *arg_ptr = malloc((num_nodes + 1) * sizeof(int));
+	int *arg_idx = malloc(5 * K * sizeof(int));
+	int *data_ptr = malloc((num_nodes + 1) * sizeof(int));
+	int *data_size = malloc(2 * num_nodes * sizeof(int));
+	double *data_val = malloc(((K + 1) + K * ((long) n * n + n)) * sizeof(double));
+	int *roots = malloc(K * sizeof(int));
+	int node = 0, nargs = 0, ndata = 0;
+	int i, k;
+
+	arg_ptr[0] = 0;
+	data_ptr[0] = 0;
+	for (k = 0; k <= K; k++, node++) {
+		type[node] = CVXCANON_OP_VARIABLE;
+		size[2 * node] = n;
+		size[2 * node + 1] = 1;
+		data_size[2 * node] = 1;
+		data_size[2 * node + 1] = 1;
+		data_val[ndata++] = k;
+		arg_ptr[node + 1] = nargs;
+		data_ptr[node + 1] = ndata;
+	}
+	for (k = 0; k < K; k++) {
+		int sum = node, mul = node + 1, neg = node + 2, cst = node + 3;
+		for (i = 0; i < 4; i++) {
+			size[2 * (node + i)] = n;
+			size[2 * (node + i) + 1] = 1;
+			data_size[2 * (node + i)] = 0;
+			data_size[2 * (node + i) + 1] = 0;
+		}
+		type[sum] = CVXCANON_OP_SUM;
+		arg_idx[nargs++] = mul;
+		arg_idx[nargs++] = neg;
+		arg_idx[nargs++] = cst;
+		arg_ptr[sum + 1] = nargs;
+		data_ptr[sum + 1] = ndata;
+
+		type[mul] = CVXCANON_OP_MUL;
+		arg_idx[nargs++] = k;
+		arg_ptr[mul + 1] = nargs;
+		data_size[2 * mul] = n;
+		data_size[2 * mul + 1] = n;
+		for (i = 0; i < n * n; i++) {
+			data_val[ndata++] = (double) rand() / RAND_MAX;
+		}
+		data_ptr[mul + 1] = ndata;
+
+		type[neg] = CVXCANON_OP_NEG;
+		arg_idx[nargs++] = k + 1;
+		arg_ptr[neg + 1] = nargs;
+		data_ptr[neg + 1] = ndata;
+
+		type[cst] = CVXCANON_OP_DENSE_CONST;
+		arg_ptr[cst + 1] = nargs;
+		data_size[2 * cst] = n;
+		data_size[2 * cst + 1] = 1;
+		for (i = 0; i < n; i++) {
+			data_val[ndata++] = 1.0;
+		}
+		data_ptr[cst + 1] = ndata;
+
+		roots[k] = sum;
+		node += 4;
+	}
+
+	cvxcanon_tree tree = {0};
+	tree.num_nodes = num_nodes;
+	tree.type = type;
+	tree.size = size;
+	tree.arg_ptr = arg_ptr;
+	tree.arg_idx = arg_idx;
+	tree.data_ptr = data_ptr;
+	tree.data_size = data_size;
+	tree.data_val = data_val;
+
+	printf("n = %d, K = %d\n", n, K);
+	run(&tree, K, roots, repeats, 0);
+	run(&tree, K, roots, repeats, 1);
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark for the coefficient builders of the KRON, RMUL, MUL, CONV and
+ * HSTACK / VSTACK linOps, which fill their coefficients in parallel.
+ *
+ * Times get_func_coeffs on one large instance of each linOp and checks
+ * that repeated builds give bit for bit identical coefficients. The number
+ * of threads follows the affinity mask of the process, so scaling is
+ * measured by restricting the cores with taskset. See tests/c/README for
+ * how to build it:
+ *
+ *     for t in 1 2 4 8 16 32; do
+ *         taskset -c 0-$((t - 1)) ./benchmark_builders [N] [REPEATS]
+ *     done
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "LinOpForest.hpp"
+#include "LinOpOperations.hpp"
+#include "Parallel.hpp"
+
+static double now() {
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Returns a ROWS x COLS matrix with about DENSITY of its entries nonzero */
+static Matrix random_sparse(int rows, int cols, double density) {
+	std::vector<Triplet> tripletList;
+	for (int j = 0; j < cols; j++) {
+		for (int i = 0; i < rows; i++) {
+			if ((double) rand() / RAND_MAX < density) {
+				tripletList.push_back(Triplet(i, j, (double) rand() / RAND_MAX));
+			}
+		}
+	}
+	Matrix mat(rows, cols);
+	mat.setFromTriplets(tripletList.begin(), tripletList.end());
+	return mat;
+}
+
+static bool same(const Matrix &a, const Matrix &b) {
+	return a.rows() == b.rows() && a.cols() == b.cols() &&
+	       a.nonZeros() == b.nonZeros() &&
+	       memcmp(a.outerIndexPtr(), b.outerIndexPtr(),
+	              (a.cols() + 1) * sizeof(int)) == 0 &&
+	       memcmp(a.innerIndexPtr(), b.innerIndexPtr(),
+	              a.nonZeros() * sizeof(int)) == 0 &&
+	       memcmp(a.valuePtr(), b.valuePtr(),
+	              a.nonZeros() * sizeof(double)) == 0;
+}
+
+/* Times REPEATS builds of the coefficients of LIN */
+static void run(const std::string &name, LinOp *lin, int repeats) {
+	std::vector<Matrix> first = get_func_coeffs(*lin);
+	long nnz = 0;
+	for (unsigned i = 0; i < first.size(); i++) {
+		nnz += first[i].nonZeros();
+	}
+	double total = 0;
+	bool deterministic = true;
+	for (int r = 0; r < repeats; r++) {
+		double t0 = now();
+		std::vector<Matrix> coeffs = get_func_coeffs(*lin);
+		total += now() - t0;
+		for (unsigned i = 0; i < coeffs.size(); i++) {
+			deterministic = deterministic && same(coeffs[i], first[i]);
+		}
+	}
+	printf("%-7s nnz = %10ld  %.4f s  %7.1f Mnnz/s%s\n", name.c_str(), nnz,
+	       total / repeats, nnz * repeats / total / 1e6,
+	       deterministic ? "" : "  NOT DETERMINISTIC");
+}
+
+int main(int argc, char **argv) {
+	int n = argc > 1 ? atoi(argv[1]) : 1000;
+	int repeats = argc > 2 ? atoi(argv[2]) : 5;
+
+	LinOpForest forest;
+	LinOp *X = forest.variable(0, n, n);
+	LinOp *Y = forest.variable(1, n, n);
+	LinOp *x = forest.variable(2, n * n, 1);
+	std::vector<LinOp*> args;
+	args.push_back(X);
+	args.push_back(Y);
+
+	printf("n = %d, threads = %d\n", n, get_num_threads());
+	run("kron", forest.kron(random_sparse(4, 4, 0.5), X), repeats);
+	run("rmul", forest.rmul(X, random_sparse(n, n, 0.01)), repeats);
+	run("mul", forest.mul(random_sparse(n, n, 0.01), X), repeats);
+	run("conv", forest.conv(random_sparse(64, 1, 1.0), x), repeats);
+	run("hstack", forest.hstack(args), repeats);
+	run("vstack", forest.vstack(args), repeats);
+	return 0;
+}
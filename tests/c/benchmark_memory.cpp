@@ -0,0 +1,147 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark for the placement of the output buffers, see MemoryPolicy in
+ * ExecutionContext.hpp.
+ *
+ * Builds K constraints A_k * x_k == 0 with sparse N x N matrices A_k into
+ * buffers placed by each memory policy, with and without transparent huge
+ * pages, and then measures the bandwidth a consumer sees when it streams
+ * V, I and J with one thread per CPU, each thread reading one contiguous
+ * part, as a solver's matrix-vector product does. The build itself runs
+ * on one thread, which is what places the pages of MEMORY_DEFAULT on a
+ * single socket. See tests/c/README for how to build it:
+ *
+ *     ./benchmark_memory [N] [K] [REPEATS]
+ *
+ * Linux only. On a machine with one NUMA node all policies place the pages
+ * the same way, and only the huge page rows differ.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+#include "Parallel.hpp"
+
+/* Keeps the consumer loop from being optimized away */
+static volatile double sink;
+
+static double now() {
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Returns the AnonHugePages of this process in MB, or -1 if unknown */
+static double huge_page_mb() {
+	std::ifstream file("/proc/self/smaps_rollup");
+	std::string line;
+	while (std::getline(file, line)) {
+		long kb;
+		if (sscanf(line.c_str(), "AnonHugePages: %ld kB", &kb) == 1) {
+			return kb / 1024.0;
+		}
+	}
+	return -1;
+}
+
+/* Streams V, I and J with one pinned thread per CPU, each reading one
+ * contiguous part, and returns the bandwidth in GB/s. */
+static double consumer_bandwidth(ProblemData &data, int repeats) {
+	std::vector<int> cpus = get_allowed_cpus();
+	int num_threads = cpus.empty() ? 1 : cpus.size();
+	long nnz = data.get_nnz();
+	std::vector<double> partial(num_threads);
+	double start = now();
+	for (int r = 0; r < repeats; r++) {
+		std::vector<std::thread> threads;
+		for (int t = 0; t < num_threads; t++) {
+			threads.push_back(std::thread([&, t]() {
+				if (!cpus.empty()) {
+					cpu_set_t set;
+					CPU_ZERO(&set);
+					CPU_SET(cpus[t], &set);
+					pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+				}
+				double sum = 0;
+				for (long k = nnz * t / num_threads; k < nnz * (t + 1) / num_threads;
+				     k++) {
+					sum += data.V[k] * (data.I[k] - data.J[k]);
+				}
+				partial[t] += sum;
+			}));
+		}
+		for (int t = 0; t < num_threads; t++) {
+			threads[t].join();
+		}
+	}
+	double seconds = now() - start;
+	for (int t = 0; t < num_threads; t++) {
+		sink += partial[t];
+	}
+	double bytes = (double) nnz * (sizeof(double) + 2 * sizeof(int)) * repeats;
+	return bytes / seconds / 1e9;
+}
+
+int main(int argc, char **argv) {
+	int n = argc > 1 ? atoi(argv[1]) : 2000;
+	int K = argc > 2 ? atoi(argv[2]) : 100;
+	int repeats = argc > 3 ? atoi(argv[3]) : 5;
+
+	LinOpForest forest;
+	srand(1);
+	for (int k = 0; k < K; k++) {
+		std::vector<Triplet> tripletList;
+		for (int j = 0; j < n; j++) {
+			for (int i = j % 10; i < n; i += 10) {
+				tripletList.push_back(Triplet(i, j, (double) rand() / RAND_MAX));
+			}
+		}
+		Matrix A(n, n);
+		A.setFromTriplets(tripletList.begin(), tripletList.end());
+		forest.add_constraint(forest.mul(A, forest.variable(k, n, 1)));
+	}
+
+	const char *policy_names[] = {"default", "interleave", "first_touch"};
+	printf("n = %d, K = %d, NUMA nodes = %d, CPUs = %d\n", n, K,
+	       (int) get_memory_nodes().size(), (int) get_allowed_cpus().size());
+	for (int policy = MEMORY_DEFAULT; policy <= MEMORY_FIRST_TOUCH; policy++) {
+		for (int huge = 0; huge <= 1; huge++) {
+			ExecutionContext context;
+			context.num_threads = 1;
+			context.memory_policy = policy;
+			context.huge_pages = huge;
+			std::map<int, int> id_to_col;
+			double t0 = now();
+			ProblemData data = build_matrix(forest.constraints, NULL, id_to_col,
+			                                std::vector<int>(), BuildOptions(),
+			                                &context);
+			double t1 = now();
+			double huge_mb = huge_page_mb();
+			double bandwidth = consumer_bandwidth(data, repeats);
+			printf("%-11s huge pages %-3s  build %.3f s  THP %7.1f MB  "
+			       "consumer %6.2f GB/s\n", policy_names[policy],
+			       huge ? "on" : "off", t1 - t0, huge_mb, bandwidth);
+		}
+	}
+	return 0;
+}
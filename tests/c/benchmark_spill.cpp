@@ -0,0 +1,114 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark for builds with a memory budget, see
+ * BuildOptions::memory_budget.
+ *
+ * Builds K constraints kron(A, X_k) == 0 with a dense P x P matrix A and
+ * N x N variables X_k, so the LinOp trees are small and nearly all memory
+ * goes to V, I and J, and reports the build time, the peak of the
+ * anonymous memory of the process, which the kernel can only reclaim by
+ * swapping, and a checksum of the output. The memory of spilled builds is
+ * in the page cache instead, which the kernel writes back and drops under
+ * pressure. Each budget is run in its own process so the peaks are
+ * separate. See tests/c/README for how to build it:
+ *
+ *     for budget in 0 256 64; do
+ *         ./benchmark_spill [N] [P] [K] $budget [SPILL_DIR]
+ *     done
+ *
+ * BUDGET is in MB, and 0 builds in memory. Linux only.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+
+static double now() {
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Returns the RssAnon of this process in kB, or -1 if unknown */
+static long anon_kb() {
+	std::ifstream file("/proc/self/status");
+	std::string line;
+	while (std::getline(file, line)) {
+		long kb;
+		if (sscanf(line.c_str(), "RssAnon: %ld kB", &kb) == 1) {
+			return kb;
+		}
+	}
+	return -1;
+}
+
+int main(int argc, char **argv) {
+	int n = argc > 1 ? atoi(argv[1]) : 30;
+	int p = argc > 2 ? atoi(argv[2]) : 20;
+	int K = argc > 3 ? atoi(argv[3]) : 50;
+	long budget_mb = argc > 4 ? atol(argv[4]) : 0;
+
+	LinOpForest forest;
+	srand(1);
+	Eigen::MatrixXd A = Eigen::MatrixXd::Random(p, p);
+	for (int k = 0; k < K; k++) {
+		forest.add_constraint(forest.kron(A, forest.variable(k, n, n)));
+	}
+
+	/* The dense constant vector would take 8 bytes per row on top */
+	BuildOptions options;
+	options.sparse_const_vec = true;
+	options.memory_budget = budget_mb << 20;
+	if (argc > 5) {
+		options.spill_dir = argv[5];
+	}
+
+	/* Samples the anonymous memory while the build runs */
+	std::atomic<bool> done(false);
+	long base_kb = anon_kb();
+	long peak_kb = base_kb;
+	std::thread sampler([&]() {
+		while (!done) {
+			peak_kb = std::max(peak_kb, anon_kb());
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	std::map<int, int> id_to_col;
+	double start = now();
+	ProblemData data = build_matrix(forest.constraints, NULL, id_to_col,
+	                                std::vector<int>(), options);
+	double seconds = now() - start;
+	done = true;
+	sampler.join();
+
+	double checksum = 0;
+	for (long k = 0; k < data.get_nnz(); k++) {
+		checksum += data.V[k] * ((k % 7) + data.I[k] - 0.5 * data.J[k]);
+	}
+	double output_mb = data.get_nnz() * (sizeof(double) + 2 * sizeof(int)) /
+	                   1048576.0;
+	printf("budget %5ld MB  output %7.1f MB  build %.3f s  "
+	       "peak anonymous %7.1f MB  checksum %.6e\n", budget_mb, output_mb,
+	       seconds, (peak_kb - base_kb) / 1024.0, checksum);
+	return 0;
+}
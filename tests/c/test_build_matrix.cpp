@@ -0,0 +1,267 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for the column layout of build_matrix. Exits with a nonzero status
+ * if a check fails. */
+
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/* Returns the column of every entry of row I of DATA, in order */
+static std::vector<int> row_cols(const ProblemData &data, int i) {
+	std::vector<int> cols;
+	for (unsigned k = 0; k < data.V.size(); k++) {
+		if (data.I[k] == i) {
+			cols.push_back(data.J[k]);
+		}
+	}
+	return cols;
+}
+
+/* Makes LIN a ROWS x COLS node of type TYPE */
+static void init(LinOp &lin, OperatorType type, int rows, int cols) {
+	lin.type = type;
+	lin.size.push_back(rows);
+	lin.size.push_back(cols);
+}
+
+static void test_variable_columns() {
+	/* sum_entries(x) == 0 is 1 x 1 but x takes 3 columns, so y comes after
+	   them rather than after the size of the constraint */
+	LinOp x, y, sum_x;
+	init(x, VARIABLE, 3, 1);
+	x.dense_data = Eigen::MatrixXd::Constant(1, 1, 0);
+	init(y, VARIABLE, 2, 1);
+	y.dense_data = Eigen::MatrixXd::Constant(1, 1, 1);
+	init(sum_x, SUM_ENTRIES, 1, 1);
+	sum_x.args.push_back(&x);
+	std::vector<LinOp*> constraints;
+	constraints.push_back(&sum_x);
+	constraints.push_back(&y);
+
+	std::map<int, int> id_to_col;
+	ProblemData data = build_matrix(constraints, id_to_col);
+	check(data.id_to_col[0] == 0 && data.id_to_col[1] == 3,
+	      "variable columns: id_to_col");
+	check(row_cols(data, 0).size() == 3, "variable columns: x");
+	check(row_cols(data, 1) == std::vector<int>(1, 3) &&
+	      row_cols(data, 2) == std::vector<int>(1, 4),
+	      "variable columns: y after x");
+}
+
+static void test_objective() {
+	/* A x + y == 0 with the objective c1^T x + c2^T x + cz^T z + d, where z
+	   only appears in the objective */
+	LinOpForest forest;
+	LinOp *x = forest.variable(0, 3, 1);
+	LinOp *y = forest.variable(1, 2, 1);
+	LinOp *z = forest.variable(2, 4, 1);
+	Eigen::MatrixXd A(2, 3), c1(1, 3), c2(1, 3), cz(1, 4);
+	A << 1, 2, 3, 4, 5, 6;
+	c1 << 1, 0, -2;
+	c2 << 0.5, 3, 2;
+	cz << 0, 7, -1, 4;
+	double d = -1.5;
+	forest.add_constraint(forest.sum(forest.mul(A, x), y));
+	std::vector<LinOp*> terms;
+	terms.push_back(forest.mul(c1, x));
+	terms.push_back(forest.mul(cz, z));
+	terms.push_back(forest.scalar_const(d));
+	terms.push_back(forest.mul(c2, x));
+	LinOp *objective = forest.sum(terms);
+
+	ProblemData data = build_matrix(forest.constraints, objective,
+	                                std::map<int, int>(), std::vector<int>(),
+	                                BuildOptions());
+	check(data.id_to_col.size() == 3 && data.id_to_col[0] == 0 &&
+	      data.id_to_col[1] == 3 && data.id_to_col[2] == 5,
+	      "objective: columns");
+	double c[] = {1.5, 3, 0, 0, 0, 0, 7, -1, 4};
+	check(data.obj_vec == std::vector<double>(c, c + 9), "objective: obj_vec");
+	check(data.obj_offset == d, "objective: obj_offset");
+	check(row_cols(data, 0).size() == 4 && data.const_vec.size() == 2,
+	      "objective: constraint matrix");
+
+	/* Without an objective the vector stays empty */
+	ProblemData plain = build_matrix(forest.constraints, NULL,
+	                                 std::map<int, int>(), std::vector<int>(),
+	                                 BuildOptions());
+	check(plain.obj_vec.empty() && plain.obj_offset == 0,
+	      "objective: none");
+
+	/* Single precision, with the columns of x and z fixed */
+	std::map<int, int> id_to_col;
+	id_to_col[2] = 0;
+	id_to_col[0] = 4;
+	ProblemDataFloat single = build_matrix_float(forest.constraints, objective,
+	                                             id_to_col, std::vector<int>(),
+	                                             BuildOptions());
+	bool ok = single.id_to_col[2] == 0 && single.id_to_col[0] == 4 &&
+	          single.obj_offset == (float) d;
+	for (int k = 0; k < 4; k++) {
+		ok = ok && (int) single.obj_vec.size() > 6 &&
+		     single.obj_vec[k] == (float) cz(0, k);
+	}
+	for (int k = 0; k < 3; k++) {
+		ok = ok && (int) single.obj_vec.size() > 6 &&
+		     std::fabs(single.obj_vec[4 + k] - (c1(0, k) + c2(0, k))) < 1e-6;
+	}
+	check(ok, "objective: float with fixed columns");
+}
+
+/* Returns the constant vector of DATA in dense form */
+template <typename Scalar>
+static std::vector<Scalar> dense_const(ProblemDataT<Scalar> &data) {
+	std::vector<Scalar> values(data.get_num_rows());
+	if (!values.empty()) {
+		data.getConstVec(&values[0], values.size());
+	}
+	return values;
+}
+
+/* True if the sparse constant vector of DATA has sorted, unique indices
+   and no explicit zeros */
+template <typename Scalar>
+static bool is_sparse_const(const ProblemDataT<Scalar> &data) {
+	bool ok = data.sparse_const && data.const_vec.empty() &&
+	          data.const_idx.size() == data.const_val.size();
+	for (unsigned k = 0; ok && k < data.const_idx.size(); k++) {
+		ok = data.const_val[k] != 0 && data.const_idx[k] < data.const_len &&
+		     (k == 0 || data.const_idx[k] > data.const_idx[k - 1]);
+	}
+	return ok;
+}
+
+/* Builds the constraints of FOREST into DATA */
+static void build(LinOpForest &forest, const std::vector<int> &offsets,
+                  const BuildOptions &options, ProblemData &data) {
+	data = build_matrix(forest.constraints, NULL, std::map<int, int>(),
+	                    offsets, options);
+}
+
+static void build(LinOpForest &forest, const std::vector<int> &offsets,
+                  const BuildOptions &options, ProblemDataFloat &data) {
+	data = build_matrix_float(forest.constraints, NULL, std::map<int, int>(),
+	                          offsets, options);
+}
+
+/* Builds FOREST with the dense and the sparse constant vector and checks
+   that both give the same rows */
+template <typename Scalar>
+static void check_sparse_const(LinOpForest &forest,
+                               const std::vector<int> &offsets,
+                               BuildOptions options, const char *what) {
+	ProblemDataT<Scalar> dense, sparse;
+	options.sparse_const_vec = false;
+	build(forest, offsets, options, dense);
+	options.sparse_const_vec = true;
+	build(forest, offsets, options, sparse);
+	check(!dense.sparse_const && is_sparse_const(sparse), what);
+	check(sparse.get_num_rows() == dense.get_num_rows() &&
+	      dense_const(sparse) == dense.const_vec, what);
+	check(std::vector<double>(sparse.V.begin(), sparse.V.end()) ==
+	      std::vector<double>(dense.V.begin(), dense.V.end()), what);
+}
+
+static void test_sparse_const_vec() {
+	/* x + b with zeros in b, a constraint without constant, and a constant
+	   that appears twice and cancels in one row */
+	LinOpForest forest;
+	LinOp *x = forest.variable(0, 4, 1);
+	Eigen::MatrixXd b(4, 1), c(4, 1);
+	b << 0, 2, 0, -3;
+	c << 1, -2, 0, 0;
+	forest.add_constraint(forest.sum(x, forest.dense_const(b)));
+	forest.add_constraint(forest.neg(x));
+	std::vector<LinOp*> args;
+	args.push_back(forest.dense_const(c));
+	args.push_back(x);
+	args.push_back(forest.dense_const(b));
+	forest.add_constraint(forest.sum(args));
+
+	std::vector<int> gaps;
+	gaps.push_back(1);
+	gaps.push_back(7);
+	gaps.push_back(12);
+
+	BuildOptions options;
+	check_sparse_const<double>(forest, std::vector<int>(), options,
+	                           "sparse const_vec: stacked");
+	check_sparse_const<double>(forest, gaps, options,
+	                           "sparse const_vec: offsets with gaps");
+	check_sparse_const<float>(forest, gaps, options,
+	                          "sparse const_vec: float");
+	options.canonicalize = true;
+	options.equilibrate = true;
+	check_sparse_const<double>(forest, gaps, options,
+	                           "sparse const_vec: canonicalize and equilibrate");
+}
+
+/* Returns true if build_cone_matrix rejects CONE_TYPES and OPTIONS for
+   CONSTRAINTS with std::invalid_argument */
+static bool cone_rejects(std::vector<LinOp*> &constraints,
+                         const std::vector<int> &cone_types,
+                         const BuildOptions &options) {
+	try {
+		build_cone_matrix(constraints, cone_types, std::map<int, int>(), options);
+	} catch (const std::invalid_argument &) {
+		return true;
+	}
+	return false;
+}
+
+static void test_cone_arguments() {
+	LinOpForest forest;
+	forest.add_constraint(forest.variable(0, 2, 1));
+	BuildOptions options;
+	check(cone_rejects(forest.constraints, std::vector<int>(1, NUM_CONE_TYPES),
+	                   options), "cone arguments: invalid cone type");
+	check(cone_rejects(forest.constraints, std::vector<int>(2, CONE_ZERO),
+	                   options), "cone arguments: number of cone types");
+	options.equilibrate = true;
+	check(cone_rejects(forest.constraints, std::vector<int>(1, CONE_ZERO),
+	                   options), "cone arguments: equilibrate");
+	options.equilibrate = false;
+	check(!cone_rejects(forest.constraints, std::vector<int>(1, CONE_ZERO),
+	                    options), "cone arguments: valid");
+}
+
+int main() {
+	test_variable_columns();
+	test_objective();
+	test_sparse_const_vec();
+	test_cone_arguments();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_build_matrix: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,355 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for the C interface in CVXcanonC.h: the return codes for valid
+ * and invalid trees, and the copy and view of the result against a dense
+ * reference. Exits with a nonzero status if a check fails. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVXcanonC.h"
+
+#define MAX_NODES 16
+#define MAX_ARGS 16
+#define MAX_DATA 64
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/* A cvxcanon_tree with room for MAX_NODES dense nodes */
+typedef struct tree_builder {
+	int num_nodes, num_args, num_data;
+	int type[MAX_NODES];
+	int size[2 * MAX_NODES];
+	int arg_ptr[MAX_NODES + 1];
+	int arg_idx[MAX_ARGS];
+	int data_ptr[MAX_NODES + 1];
+	int data_size[2 * MAX_NODES];
+	double data_val[MAX_DATA];
+	cvxcanon_tree tree;
+} tree_builder;
+
+static void init_builder(tree_builder *b) {
+	memset(b, 0, sizeof(*b));
+}
+
+/* Adds a ROWS x COLS node of type TYPE with the NUM_ARGS nodes ARGS as
+ * children and the DATA_ROWS x DATA_COLS column major DATA, and returns
+ * its index */
+static int add_node(tree_builder *b, int type, int rows, int cols,
+                    int num_args, const int *args, int data_rows,
+                    int data_cols, const double *data) {
+	int i = b->num_nodes++;
+	int k;
+	b->type[i] = type;
+	b->size[2 * i] = rows;
+	b->size[2 * i + 1] = cols;
+	for (k = 0; k < num_args; k++) {
+		b->arg_idx[b->num_args++] = args[k];
+	}
+	b->arg_ptr[i + 1] = b->num_args;
+	b->data_size[2 * i] = data_rows;
+	b->data_size[2 * i + 1] = data_cols;
+	for (k = 0; k < data_rows * data_cols; k++) {
+		b->data_val[b->num_data++] = data[k];
+	}
+	b->data_ptr[i + 1] = b->num_data;
+	return i;
+}
+
+static const cvxcanon_tree *get_tree(tree_builder *b) {
+	memset(&b->tree, 0, sizeof(b->tree));
+	b->tree.num_nodes = b->num_nodes;
+	b->tree.type = b->type;
+	b->tree.size = b->size;
+	b->tree.arg_ptr = b->arg_ptr;
+	b->tree.arg_idx = b->arg_idx;
+	b->tree.data_ptr = b->data_ptr;
+	b->tree.data_size = b->data_size;
+	b->tree.data_val = b->data_val;
+	return &b->tree;
+}
+
+static int variable(tree_builder *b, int id, int rows) {
+	double data = id;
+	return add_node(b, CVXCANON_OP_VARIABLE, rows, 1, 0, NULL, 1, 1, &data);
+}
+
+static const double A[] = {1, 3, 5, 2, 4, 6};
+static const double c[] = {7, 8, 9};
+static const double k[] = {1, 2};
+
+/* Builds the constraints A x + y + c and kron(k, x) for a 2 x 1 variable x
+ * with id 0 and a 3 x 1 variable y with id 1, and stores their roots in
+ * ROOTS. KRON_ROWS x KRON_COLS is the size given to the KRON node. */
+static void build_example(tree_builder *b, int kron_rows, int kron_cols,
+                          int *roots) {
+	int x, y, args[3];
+	init_builder(b);
+	x = variable(b, 0, 2);
+	y = variable(b, 1, 3);
+	args[0] = add_node(b, CVXCANON_OP_MUL, 3, 1, 1, &x, 3, 2, A);
+	args[1] = y;
+	args[2] = add_node(b, CVXCANON_OP_DENSE_CONST, 3, 1, 0, NULL, 3, 1, c);
+	roots[0] = add_node(b, CVXCANON_OP_SUM, 3, 1, 3, args, 0, 0, NULL);
+	roots[1] = add_node(b, CVXCANON_OP_KRON, kron_rows, kron_cols, 1, &x, 2, 1,
+	                    k);
+}
+
+/* Dense 7 x 5 reference of the example, with x in columns 0-1 and y in
+ * columns 2-4 */
+static void reference(double *M, double *const_vec) {
+	int i;
+	memset(M, 0, 7 * 5 * sizeof(double));
+	memset(const_vec, 0, 7 * sizeof(double));
+	for (i = 0; i < 3; i++) {
+		M[i * 5 + 0] = A[i];
+		M[i * 5 + 1] = A[3 + i];
+		M[i * 5 + 2 + i] = 1;
+		const_vec[i] = c[i];
+	}
+	M[3 * 5 + 0] = k[0];
+	M[4 * 5 + 1] = k[0];
+	M[5 * 5 + 0] = k[1];
+	M[6 * 5 + 1] = k[1];
+}
+
+/* Sums the NNZ entries (V, I, J) into the dense 7 x 5 matrix M and returns
+ * whether it matches the reference along with CONST_VEC */
+static int matches(int64_t nnz, const double *V, const int *I, const int *J,
+                   const double *const_vec) {
+	double M[7 * 5], ref[7 * 5], ref_const[7];
+	int64_t e;
+	int i;
+	memset(M, 0, sizeof(M));
+	for (e = 0; e < nnz; e++) {
+		if (I[e] < 0 || I[e] >= 7 || J[e] < 0 || J[e] >= 5) {
+			return 0;
+		}
+		M[I[e] * 5 + J[e]] += V[e];
+	}
+	reference(ref, ref_const);
+	for (i = 0; i < 7 * 5; i++) {
+		if (fabs(M[i] - ref[i]) > 1e-12) {
+			return 0;
+		}
+	}
+	for (i = 0; i < 7; i++) {
+		if (fabs(const_vec[i] - ref_const[i]) > 1e-12) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static const int var_ids[] = {0, 1};
+static const int var_cols[] = {0, 2};
+
+static void test_valid_tree(void) {
+	tree_builder b;
+	int roots[2];
+	cvxcanon_problem *prob = NULL;
+	int64_t nnz = -1;
+	int num_rows = -1, num_cols = -1, num_vars = -1;
+	build_example(&b, 4, 1, roots);
+
+	check(cvxcanon_build(get_tree(&b), 2, roots, NULL, 2, var_ids, var_cols,
+	                     &prob) == CVXCANON_OK && prob != NULL,
+	      "valid tree: build");
+	if (prob == NULL) {
+		return;
+	}
+	check(cvxcanon_problem_size(prob, &nnz, &num_rows, &num_cols, &num_vars) ==
+	      CVXCANON_OK, "valid tree: size");
+	check(num_rows == 7 && num_cols == 5 && num_vars == 2 && nnz > 0,
+	      "valid tree: sizes");
+
+	{
+		double *V = malloc(nnz * sizeof(double));
+		int *I = malloc(nnz * sizeof(int));
+		int *J = malloc(nnz * sizeof(int));
+		double const_vec[7];
+		float *V_float = malloc(nnz * sizeof(float));
+		float const_float[7];
+		const double *view_V, *view_const;
+		const int *view_I, *view_J;
+		const float *view_float;
+		int ids[2], cols[2];
+		int64_t e;
+
+		check(cvxcanon_problem_copy(prob, V, I, J, const_vec) == CVXCANON_OK &&
+		      matches(nnz, V, I, J, const_vec), "valid tree: copy");
+		check(cvxcanon_problem_view(prob, &view_V, &view_I, &view_J,
+		                            &view_const) == CVXCANON_OK &&
+		      matches(nnz, view_V, view_I, view_J, view_const),
+		      "valid tree: view");
+		check(cvxcanon_problem_copy_float(prob, V_float, NULL, NULL,
+		                                  const_float) == CVXCANON_OK,
+		      "valid tree: copy_float");
+		for (e = 0; e < nnz; e++) {
+			check(V_float[e] == (float) V[e], "valid tree: copy_float V");
+		}
+		check(cvxcanon_problem_view_float(prob, &view_float, NULL, NULL,
+		                                  NULL) == CVXCANON_INVALID_ARGUMENT,
+		      "valid tree: view_float of a double problem");
+		check(cvxcanon_problem_var_cols(prob, ids, cols) == CVXCANON_OK &&
+		      ids[0] == 0 && cols[0] == 0 && ids[1] == 1 && cols[1] == 2,
+		      "valid tree: var_cols");
+		free(V);
+		free(I);
+		free(J);
+		free(V_float);
+	}
+	cvxcanon_problem_free(prob);
+}
+
+static void test_valid_tree_float(void) {
+	tree_builder b;
+	int roots[2];
+	cvxcanon_problem *prob = NULL;
+	int64_t nnz = 0;
+	build_example(&b, 4, 1, roots);
+
+	check(cvxcanon_build_float(get_tree(&b), 2, roots, NULL, 2, var_ids,
+	                           var_cols, &prob) == CVXCANON_OK,
+	      "float tree: build");
+	if (prob == NULL) {
+		return;
+	}
+	cvxcanon_problem_size(prob, &nnz, NULL, NULL, NULL);
+	{
+		double *V = malloc(nnz * sizeof(double));
+		int *I = malloc(nnz * sizeof(int));
+		int *J = malloc(nnz * sizeof(int));
+		double const_vec[7];
+		const float *view_V, *view_const;
+		const double *view_double;
+		int64_t e;
+		int i;
+
+		check(cvxcanon_problem_copy(prob, V, I, J, const_vec) == CVXCANON_OK &&
+		      matches(nnz, V, I, J, const_vec), "float tree: copy");
+		check(cvxcanon_problem_view_float(prob, &view_V, NULL, NULL,
+		                                  &view_const) == CVXCANON_OK,
+		      "float tree: view_float");
+		for (e = 0; e < nnz; e++) {
+			check(view_V[e] == V[e], "float tree: view_float V");
+		}
+		for (i = 0; i < 7; i++) {
+			check(view_const[i] == const_vec[i], "float tree: view_float const");
+		}
+		check(cvxcanon_problem_view(prob, &view_double, NULL, NULL, NULL) ==
+		      CVXCANON_INVALID_ARGUMENT,
+		      "float tree: view of a float problem");
+		free(V);
+		free(I);
+		free(J);
+	}
+	cvxcanon_problem_free(prob);
+}
+
+/* Returns the status of building the constraints ROOTS of B */
+static int build_status(tree_builder *b, int num_roots, const int *roots) {
+	cvxcanon_problem *prob = (cvxcanon_problem *) 1;
+	int status = cvxcanon_build(get_tree(b), num_roots, roots, NULL, 0, NULL,
+	                            NULL, &prob);
+	if (status == CVXCANON_OK) {
+		cvxcanon_problem_free(prob);
+	} else {
+		check(prob == NULL, "invalid tree: output is cleared");
+	}
+	return status;
+}
+
+static void test_invalid_trees(void) {
+	tree_builder b;
+	int roots[2];
+	int x;
+	cvxcanon_problem *prob;
+
+	/* The KRON node has the right number of entries but the wrong shape */
+	build_example(&b, 2, 2, roots);
+	check(build_status(&b, 2, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: kron shape");
+	build_example(&b, 1, 4, roots);
+	check(build_status(&b, 2, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: kron transposed");
+
+	/* MUL data that does not fit its argument */
+	init_builder(&b);
+	x = variable(&b, 0, 3);
+	roots[0] = add_node(&b, CVXCANON_OP_MUL, 3, 1, 1, &x, 3, 2, A);
+	check(build_status(&b, 1, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: mul shape");
+
+	/* SUM of arguments with different sizes */
+	init_builder(&b);
+	{
+		int args[2];
+		args[0] = variable(&b, 0, 2);
+		args[1] = variable(&b, 1, 3);
+		roots[0] = add_node(&b, CVXCANON_OP_SUM, 2, 1, 2, args, 0, 0, NULL);
+	}
+	check(build_status(&b, 1, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: sum sizes");
+
+	/* A child index out of range */
+	build_example(&b, 4, 1, roots);
+	b.arg_idx[0] = b.num_nodes;
+	check(build_status(&b, 2, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: child index");
+
+	/* A cycle */
+	init_builder(&b);
+	x = 1;
+	add_node(&b, CVXCANON_OP_NEG, 2, 1, 1, &x, 0, 0, NULL);
+	x = 0;
+	roots[0] = add_node(&b, CVXCANON_OP_NEG, 2, 1, 1, &x, 0, 0, NULL);
+	check(build_status(&b, 1, roots) == CVXCANON_INVALID_TREE,
+	      "invalid tree: cycle");
+
+	/* Invalid arguments */
+	build_example(&b, 4, 1, roots);
+	check(cvxcanon_build(get_tree(&b), 2, roots, NULL, 0, NULL, NULL, NULL) ==
+	      CVXCANON_INVALID_ARGUMENT, "invalid argument: output");
+	check(cvxcanon_build(NULL, 2, roots, NULL, 0, NULL, NULL, &prob) ==
+	      CVXCANON_INVALID_ARGUMENT, "invalid argument: tree");
+	roots[1] = b.num_nodes;
+	check(build_status(&b, 2, roots) == CVXCANON_INVALID_ARGUMENT,
+	      "invalid argument: constraint index");
+	check(cvxcanon_problem_size(NULL, NULL, NULL, NULL, NULL) ==
+	      CVXCANON_INVALID_ARGUMENT, "invalid argument: size");
+}
+
+int main(void) {
+	test_valid_tree();
+	test_valid_tree_float();
+	test_invalid_trees();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_c_api: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,507 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for the coefficients of the linOps in LinOpOperations.cpp. Each
+ * operator is compared against a dense reference that applies it to every
+ * unit matrix, through get_func_coeffs, apply_func_coeff and build_matrix.
+ * QUAD_FORM is compared through build_quad_matrix. Exits with a nonzero
+ * status if a check fails. */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+#include "LinOpOperations.hpp"
+
+typedef std::function<Eigen::MatrixXd(const Eigen::MatrixXd &)> DenseOp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static bool approx(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B) {
+	if (A.rows() != B.rows() || A.cols() != B.cols()) {
+		return false;
+	}
+	return A.size() == 0 || (A - B).cwiseAbs().maxCoeff() <= 1e-12;
+}
+
+/* Returns the dense coefficient of OP for ROWS x COLS arguments: column K is
+ * the vectorized result of OP on the K-th unit matrix */
+static Eigen::MatrixXd reference(const DenseOp &op, int rows, int cols) {
+	Eigen::MatrixXd coeffs;
+	for (int k = 0; k < rows * cols; k++) {
+		Eigen::MatrixXd unit = Eigen::MatrixXd::Zero(rows, cols);
+		unit(k % rows, k / rows) = 1;
+		Eigen::MatrixXd result = op(unit);
+		if (k == 0) {
+			coeffs.resize(result.size(), rows * cols);
+		}
+		coeffs.col(k) = Eigen::Map<Eigen::VectorXd>(result.data(), result.size());
+	}
+	return coeffs;
+}
+
+/* Returns A of the constraints of FOREST, with NUM_COLS columns, and checks
+ * that their constant is zero */
+static Eigen::MatrixXd build_dense(LinOpForest &forest, int num_cols,
+                                   const char *name) {
+	std::map<int, int> id_to_col;
+	ProblemData data = build_matrix(forest.constraints, id_to_col);
+	Eigen::MatrixXd A = Eigen::MatrixXd::Zero(data.const_vec.size(), num_cols);
+	for (long k = 0; k < data.get_nnz(); k++) {
+		A(data.I[k], data.J[k]) += data.V[k];
+	}
+	for (unsigned i = 0; i < data.const_vec.size(); i++) {
+		check(data.const_vec[i] == 0, name);
+	}
+	return A;
+}
+
+/* Checks the coefficient of LIN, a linOp over a single variable, against
+ * the dense reference OP */
+static void check_op(LinOpForest &forest, LinOp *lin, const DenseOp &op,
+                     const char *name) {
+	int rows = lin->args[0]->size[0];
+	int cols = lin->args[0]->size[1];
+	Eigen::MatrixXd expected = reference(op, rows, cols);
+	check(expected.rows() == lin->size[0] * lin->size[1], name);
+
+	Matrix coeffs = get_func_coeffs(*lin)[0];
+	check(approx(Eigen::MatrixXd(coeffs), expected), name);
+
+	if (has_func_apply(*lin)) {
+		Matrix rh = Eigen::MatrixXd::Random(rows * cols, 3).sparseView();
+		check(approx(Eigen::MatrixXd(apply_func_coeff(*lin, 0, rh)),
+		             expected * Eigen::MatrixXd(rh)), name);
+	}
+
+	forest.add_constraint(lin);
+	check(approx(build_dense(forest, rows * cols, name), expected), name);
+}
+
+/* Argument shapes, including a row and a column */
+static const int NUM_SHAPES = 4;
+static const int shapes[NUM_SHAPES][2] = {{3, 4}, {1, 5}, {5, 1}, {1, 1}};
+
+static void test_sum_axis() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		for (int axis = 0; axis < 2; axis++) {
+			LinOpForest forest;
+			LinOp *x = forest.variable(0, shapes[s][0], shapes[s][1]);
+			check_op(forest, forest.sum_axis(x, axis),
+			         [axis](const Eigen::MatrixXd &X) -> Eigen::MatrixXd {
+				if (axis == 0) {
+					return X.colwise().sum();
+				}
+				return X.rowwise().sum();
+			}, "sum_axis");
+		}
+	}
+}
+
+/* Returns the running sums of X along AXIS */
+static Eigen::MatrixXd dense_cumsum(const Eigen::MatrixXd &X, int axis) {
+	Eigen::MatrixXd Y = X;
+	for (int i = 0; i < X.rows(); i++) {
+		for (int j = 0; j < X.cols(); j++) {
+			if (axis == 0 && i > 0) {
+				Y(i, j) += Y(i - 1, j);
+			} else if (axis == 1 && j > 0) {
+				Y(i, j) += Y(i, j - 1);
+			}
+		}
+	}
+	return Y;
+}
+
+/* Returns the ORDER-th forward difference of X along AXIS */
+static Eigen::MatrixXd dense_diff(const Eigen::MatrixXd &X, int axis,
+                                  int order) {
+	Eigen::MatrixXd Y = X;
+	for (int k = 0; k < order; k++) {
+		if (axis == 0) {
+			Y = Eigen::MatrixXd(Y.bottomRows(Y.rows() - 1) -
+			                    Y.topRows(Y.rows() - 1));
+		} else {
+			Y = Eigen::MatrixXd(Y.rightCols(Y.cols() - 1) -
+			                    Y.leftCols(Y.cols() - 1));
+		}
+	}
+	return Y;
+}
+
+static void test_cumsum() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		for (int axis = 0; axis < 2; axis++) {
+			LinOpForest forest;
+			LinOp *x = forest.variable(0, shapes[s][0], shapes[s][1]);
+			check_op(forest, forest.cumsum(x, axis),
+			         [axis](const Eigen::MatrixXd &X) {
+				return dense_cumsum(X, axis);
+			}, "cumsum");
+		}
+	}
+}
+
+static void test_diff() {
+	/* Every order up to the length of the axis, where the result is empty */
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		for (int axis = 0; axis < 2; axis++) {
+			for (int order = 0; order <= shapes[s][axis]; order++) {
+				LinOpForest forest;
+				LinOp *x = forest.variable(0, shapes[s][0], shapes[s][1]);
+				LinOp *lin = forest.diff(x, axis, order);
+				check(order < shapes[s][axis] ||
+				      lin->size[0] * lin->size[1] == 0, "diff: empty result");
+				check_op(forest, lin, [axis, order](const Eigen::MatrixXd &X) {
+					return dense_diff(X, axis, order);
+				}, "diff");
+			}
+		}
+	}
+}
+
+/* Returns X times C entrywise, with C broadcast along its singleton
+ * dimensions */
+static Eigen::MatrixXd dense_mul_elem(const Eigen::MatrixXd &C,
+                                      const Eigen::MatrixXd &X) {
+	Eigen::MatrixXd Y = X;
+	for (int i = 0; i < X.rows(); i++) {
+		for (int j = 0; j < X.cols(); j++) {
+			Y(i, j) *= C(C.rows() == 1 ? 0 : i, C.cols() == 1 ? 0 : j);
+		}
+	}
+	return Y;
+}
+
+static void test_mul_elem() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		int m = shapes[s][0], n = shapes[s][1];
+		/* Full, row, column and scalar constants */
+		int sizes[][2] = {{m, n}, {1, n}, {m, 1}, {1, 1}};
+		for (int c = 0; c < 4; c++) {
+			Eigen::MatrixXd C = Eigen::MatrixXd::Random(sizes[c][0], sizes[c][1]);
+			C(0, 0) = 0;
+			DenseOp op = [C](const Eigen::MatrixXd &X) {
+				return dense_mul_elem(C, X);
+			};
+
+			LinOpForest forest;
+			LinOp *x = forest.variable(0, m, n);
+			check_op(forest, forest.mul_elem(C, x), op, "mul_elem: dense");
+
+			LinOpForest sparse_forest;
+			x = sparse_forest.variable(0, m, n);
+			Matrix sparse_C = C.sparseView();
+			check_op(sparse_forest, sparse_forest.mul_elem(sparse_C, x), op,
+			         "mul_elem: sparse");
+		}
+	}
+}
+
+/* Returns [B_1 X_1 ... B_K X_K] for the K equal width column blocks X_I
+ * of X */
+static Eigen::MatrixXd dense_block_diag_mul(
+	const std::vector<Eigen::MatrixXd> &blocks, const Eigen::MatrixXd &X) {
+	int width = X.cols() / blocks.size();
+	Eigen::MatrixXd Y(blocks[0].rows(), X.cols());
+	for (unsigned i = 0; i < blocks.size(); i++) {
+		Y.middleCols(i * width, width) = blocks[i] * X.middleCols(i * width,
+		                                                           width);
+	}
+	return Y;
+}
+
+static void test_block_diag_mul() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		int m = shapes[s][0], n = shapes[s][1];
+		/* One block, one block per column, and blocks of one or two rows */
+		for (int num_blocks = 1; num_blocks <= n; num_blocks++) {
+			if (n % num_blocks != 0 || (num_blocks > 2 && num_blocks < n)) {
+				continue;
+			}
+			for (int p = 1; p <= 2; p++) {
+				std::vector<Eigen::MatrixXd> blocks;
+				std::vector<Matrix> sparse_blocks;
+				for (int i = 0; i < num_blocks; i++) {
+					blocks.push_back(Eigen::MatrixXd::Random(p, m));
+					blocks.back()(0, 0) = 0;
+					sparse_blocks.push_back(blocks.back().sparseView());
+				}
+				DenseOp op = [blocks](const Eigen::MatrixXd &X) {
+					return dense_block_diag_mul(blocks, X);
+				};
+
+				LinOpForest forest;
+				LinOp *x = forest.variable(0, m, n);
+				check_op(forest, forest.block_diag_mul(blocks, x), op,
+				         "block_diag_mul: dense");
+
+				LinOpForest sparse_forest;
+				x = sparse_forest.variable(0, m, n);
+				check_op(sparse_forest, sparse_forest.block_diag_mul(sparse_blocks, x),
+				         op, "block_diag_mul: sparse");
+			}
+		}
+	}
+}
+
+/* Returns the lower triangle of X column by column, with the off-diagonal
+ * entries taken as sqrt(2) (X_ij + X_ji) / 2 */
+static Eigen::MatrixXd dense_svec(const Eigen::MatrixXd &X) {
+	int n = X.rows();
+	Eigen::MatrixXd y(n * (n + 1) / 2, 1);
+	int row = 0;
+	for (int j = 0; j < n; j++) {
+		y(row++, 0) = X(j, j);
+		for (int i = j + 1; i < n; i++) {
+			y(row++, 0) = std::sqrt(2.0) * (X(i, j) + X(j, i)) / 2;
+		}
+	}
+	return y;
+}
+
+static void test_svec() {
+	/* SVEC takes square arguments only */
+	for (int n = 1; n <= 4; n++) {
+		LinOpForest forest;
+		LinOp *x = forest.variable(0, n, n);
+		check_op(forest, forest.svec(x), dense_svec, "svec");
+	}
+}
+
+/* Returns kron(X, C) */
+static Eigen::MatrixXd dense_kron_right(const Eigen::MatrixXd &X,
+                                        const Eigen::MatrixXd &C) {
+	Eigen::MatrixXd Y(X.rows() * C.rows(), X.cols() * C.cols());
+	for (int i = 0; i < X.rows(); i++) {
+		for (int j = 0; j < X.cols(); j++) {
+			Y.block(i * C.rows(), j * C.cols(), C.rows(), C.cols()) = X(i, j) * C;
+		}
+	}
+	return Y;
+}
+
+/* Constant shapes, including a row and a column */
+static const int constant_shapes[NUM_SHAPES][2] = {{2, 3}, {1, 3}, {3, 1},
+                                                    {1, 1}};
+
+static void test_kron_right() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		for (int c = 0; c < NUM_SHAPES; c++) {
+			Eigen::MatrixXd C = Eigen::MatrixXd::Random(constant_shapes[c][0],
+			                                            constant_shapes[c][1]);
+			C(0, 0) = 0;
+			DenseOp op = [C](const Eigen::MatrixXd &X) {
+				return dense_kron_right(X, C);
+			};
+
+			LinOpForest forest;
+			LinOp *x = forest.variable(0, shapes[s][0], shapes[s][1]);
+			check_op(forest, forest.kron_right(x, C), op, "kron_right: dense");
+
+			LinOpForest sparse_forest;
+			x = sparse_forest.variable(0, shapes[s][0], shapes[s][1]);
+			Matrix sparse_C = C.sparseView();
+			check_op(sparse_forest, sparse_forest.kron_right(x, sparse_C), op,
+			         "kron_right: sparse");
+		}
+	}
+}
+
+/* Returns the full 2-D convolution of X with the kernel K */
+static Eigen::MatrixXd dense_conv2d(const Eigen::MatrixXd &K,
+                                    const Eigen::MatrixXd &X) {
+	Eigen::MatrixXd Y = Eigen::MatrixXd::Zero(X.rows() + K.rows() - 1,
+	                                          X.cols() + K.cols() - 1);
+	for (int i = 0; i < X.rows(); i++) {
+		for (int j = 0; j < X.cols(); j++) {
+			Y.block(i, j, K.rows(), K.cols()) += X(i, j) * K;
+		}
+	}
+	return Y;
+}
+
+static void test_conv2d() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		for (int c = 0; c < NUM_SHAPES; c++) {
+			Eigen::MatrixXd K = Eigen::MatrixXd::Random(constant_shapes[c][0],
+			                                            constant_shapes[c][1]);
+			K(0, 0) = 0;
+			DenseOp op = [K](const Eigen::MatrixXd &X) {
+				return dense_conv2d(K, X);
+			};
+
+			LinOpForest forest;
+			LinOp *x = forest.variable(0, shapes[s][0], shapes[s][1]);
+			check_op(forest, forest.conv2d(K, x), op, "conv2d: dense");
+
+			LinOpForest sparse_forest;
+			x = sparse_forest.variable(0, shapes[s][0], shapes[s][1]);
+			Matrix sparse_K = K.sparseView();
+			check_op(sparse_forest, sparse_forest.conv2d(sparse_K, x), op,
+			         "conv2d: sparse");
+		}
+	}
+}
+
+/* Returns the symmetric P of QUAD, from its upper triangle, and checks that
+ * only the upper triangle is stored */
+static Eigen::MatrixXd dense_P(const QuadProblemData &quad) {
+	int n = quad.num_cols;
+	Eigen::MatrixXd P = Eigen::MatrixXd::Zero(n, n);
+	for (int j = 0; j < n; j++) {
+		for (int k = quad.P_indptr[j]; k < quad.P_indptr[j + 1]; k++) {
+			int i = quad.P_indices[k];
+			check(i <= j, "quad_form: upper triangle");
+			P(i, j) = quad.P_data[k];
+			P(j, i) = quad.P_data[k];
+		}
+	}
+	return P;
+}
+
+static void test_quad_form() {
+	for (int s = 0; s < NUM_SHAPES; s++) {
+		int m = shapes[s][0], n = shapes[s][1];
+		/* (A X + C)^T Q (A X + C) with a non-symmetric Q, plus the sum of
+		   squares of a second variable Y with 3 entries. Two extra columns
+		   pad P to NUM_COLS. */
+		Eigen::MatrixXd A = Eigen::MatrixXd::Random(2, m);
+		Eigen::MatrixXd C = Eigen::MatrixXd::Random(2, n);
+		Eigen::MatrixXd Q = Eigen::MatrixXd::Random(2 * n, 2 * n);
+		int num_vars = m * n + 3;
+		int num_cols = num_vars + 2;
+
+		LinOpForest forest;
+		LinOp *x = forest.variable(0, m, n);
+		LinOp *y = forest.variable(1, 1, 3);
+		std::vector<LinOp*> terms;
+		terms.push_back(forest.quad_form(
+			forest.sum(forest.mul(A, x), forest.dense_const(C)), Q));
+		terms.push_back(forest.sum_squares(y));
+		std::map<int, int> id_to_col;
+		id_to_col[0] = 0;
+		id_to_col[1] = m * n;
+		QuadProblemData quad = build_quad_matrix(terms, id_to_col, num_cols);
+
+		/* The argument of the first term is B vec(X) + vec(C) */
+		Eigen::MatrixXd B = reference([A](const Eigen::MatrixXd &X) {
+			return Eigen::MatrixXd(A * X);
+		}, m, n);
+		Eigen::VectorXd c = Eigen::Map<Eigen::VectorXd>(C.data(), C.size());
+		Eigen::MatrixXd Q_sym = Q + Q.transpose();
+
+		Eigen::MatrixXd P = Eigen::MatrixXd::Zero(num_cols, num_cols);
+		P.topLeftCorner(m * n, m * n) = B.transpose() * Q_sym * B;
+		P.block(m * n, m * n, 3, 3) = 2 * Eigen::MatrixXd::Identity(3, 3);
+		Eigen::VectorXd q = Eigen::VectorXd::Zero(num_cols);
+		q.head(m * n) = B.transpose() * Q_sym * c;
+		double r = c.dot(Q * c);
+
+		check(quad.num_cols == num_cols && quad.q.size() == (unsigned) num_cols,
+		      "quad_form: number of columns");
+		check(approx(dense_P(quad), P), "quad_form: P");
+		Eigen::VectorXd quad_q = Eigen::Map<Eigen::VectorXd>(quad.q.data(),
+		                                                     quad.q.size());
+		check(approx(quad_q, q), "quad_form: q");
+		check(std::fabs(quad.r - r) <= 1e-12, "quad_form: r");
+	}
+}
+
+/* Returns true if BUILD throws std::invalid_argument without adding a node
+   to FOREST */
+static bool rejects(LinOpForest &forest, const std::function<void()> &build) {
+	int size = forest.size();
+	try {
+		build();
+	} catch (const std::invalid_argument &) {
+		return forest.size() == size;
+	}
+	return false;
+}
+
+static void test_shape_checks() {
+	LinOpForest forest;
+	LinOp *x = forest.variable(0, 3, 4);
+	LinOp *y = forest.variable(1, 4, 3);
+	std::vector<LinOp*> xy;
+	xy.push_back(x);
+	xy.push_back(y);
+	std::vector<Eigen::MatrixXd> blocks;
+	blocks.push_back(Eigen::MatrixXd::Ones(2, 3));
+	blocks.push_back(Eigen::MatrixXd::Ones(2, 2));
+
+	check(rejects(forest, [&]() { forest.mul(Eigen::MatrixXd::Ones(2, 2), x); }),
+	      "shape checks: mul");
+	check(rejects(forest, [&]() { forest.rmul(x, Eigen::MatrixXd::Ones(3, 2)); }),
+	      "shape checks: rmul");
+	check(rejects(forest, [&]() {
+		forest.mul_elem(Eigen::MatrixXd::Ones(2, 4), x);
+	}), "shape checks: mul_elem");
+	check(rejects(forest, [&]() { forest.sum(x, y); }), "shape checks: sum");
+	check(rejects(forest, [&]() { forest.hstack(xy); }), "shape checks: hstack");
+	check(rejects(forest, [&]() { forest.vstack(xy); }), "shape checks: vstack");
+	check(rejects(forest, [&]() { forest.hstack(std::vector<LinOp*>()); }),
+	      "shape checks: empty hstack");
+	check(rejects(forest, [&]() { forest.index(x, 0, 3, 0, 0, 4, 1); }),
+	      "shape checks: index step");
+	check(rejects(forest, [&]() { forest.sum_axis(x, 2); }),
+	      "shape checks: sum_axis");
+	check(rejects(forest, [&]() { forest.cumsum(x, -1); }),
+	      "shape checks: cumsum");
+	check(rejects(forest, [&]() { forest.diff(x, 0, 4); }), "shape checks: diff");
+	check(rejects(forest, [&]() { forest.reshape(x, 5, 2); }),
+	      "shape checks: reshape");
+	check(rejects(forest, [&]() { forest.svec(x); }), "shape checks: svec");
+	check(rejects(forest, [&]() { forest.trace(x); }), "shape checks: trace");
+	check(rejects(forest, [&]() { forest.block_diag_mul(blocks, x); }),
+	      "shape checks: block_diag_mul");
+	check(rejects(forest, [&]() {
+		forest.quad_form(x, Eigen::MatrixXd::Identity(3, 3));
+	}), "shape checks: quad_form");
+}
+
+int main() {
+	srand(1);
+	test_sum_axis();
+	test_cumsum();
+	test_diff();
+	test_mul_elem();
+	test_block_diag_mul();
+	test_svec();
+	test_kron_right();
+	test_conv2d();
+	test_quad_form();
+	test_shape_checks();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_linops: all checks passed\n");
+	return 0;
+}
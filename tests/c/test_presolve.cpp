@@ -0,0 +1,315 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for presolve, postsolve and the parallel row pass in Presolve.hpp.
+ * Exits with a nonzero status if a check fails. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Presolve.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static bool approx(double a, double b) {
+	return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b));
+}
+
+static void add(ProblemData &data, int i, int j, double v) {
+	data.I.push_back(i);
+	data.J.push_back(j);
+	data.V.push_back(v);
+}
+
+/* Returns row I of A x + b for the problem data DATA */
+static double row_value(const ProblemData &data, int i,
+                        const std::vector<double> &x) {
+	double value = data.const_vec[i];
+	for (unsigned long k = 0; k < data.V.size(); k++) {
+		if (data.I[k] == i) {
+			value += data.V[k] * x[data.J[k]];
+		}
+	}
+	return value;
+}
+
+/* Columns x0, ..., x4 and rows
+ *
+ *     0 (zero):     x0 - 2            x0 = 2
+ *     1 (zero):     x0 + x1 - 5       x1 = 3 once x0 is substituted
+ *     2 (nonneg):   -x2 + 1           x2 >= 1
+ *     3 (nonneg):   2 x2 - 8          x2 <= 4
+ *     4 (nonneg):   x1 + x3 + x4      kept, x1 becomes a constant
+ *     5 (other):    x2 + x3           kept, not reducible
+ *
+ * with objective x0 + 2 x1 + 0.5 x2 + 0.25. */
+static ProblemData chain_problem() {
+	ProblemData data;
+	add(data, 0, 0, 1);
+	add(data, 1, 0, 1);
+	add(data, 1, 1, 1);
+	add(data, 2, 2, -1);
+	add(data, 3, 2, 2);
+	add(data, 4, 1, 1);
+	add(data, 4, 3, 1);
+	add(data, 4, 4, 1);
+	add(data, 5, 2, 1);
+	add(data, 5, 3, 1);
+	double b[] = {-2, -5, 1, -8, 0, 0};
+	data.const_vec.assign(b, b + 6);
+	double c[] = {1, 2, 0.5, 0, 0};
+	data.obj_vec.assign(c, c + 5);
+	data.obj_offset = 0.25;
+	return data;
+}
+
+static int find(const std::vector<int> &map, int value) {
+	for (unsigned k = 0; k < map.size(); k++) {
+		if (map[k] == value) {
+			return k;
+		}
+	}
+	return -1;
+}
+
+static void test_singleton_propagation() {
+	ProblemData data = chain_problem();
+	PresolveInfo info = presolve(data, 2, 3, 5, 1e-9);
+	check(info.status == PRESOLVE_OK, "chain: status");
+	check(info.orig_rows == 6 && info.orig_cols == 5, "chain: original size");
+
+	/* Row 0 fixes x0, which turns row 1 into a singleton fixing x1 */
+	check(info.num_zero_rows == 0, "chain: equalities removed");
+	check(find(info.col_map, 0) < 0 && find(info.col_map, 1) < 0,
+	      "chain: fixed columns removed");
+	check(approx(info.col_value[0], 2) && approx(info.col_value[1], 3),
+	      "chain: fixed values");
+
+	/* Row 4 loses x1 and picks up its value in the constant */
+	int row = find(info.row_map, 4);
+	check(row >= 0 && approx(data.const_vec[row], 3),
+	      "chain: fixed column moved to the constant");
+}
+
+static void test_inequality_bounds() {
+	ProblemData data = chain_problem();
+	PresolveInfo info = presolve(data, 2, 3, 5, 1e-9);
+	check(find(info.row_map, 2) < 0 && find(info.row_map, 3) < 0,
+	      "bounds: singleton inequalities removed");
+	check(info.num_nonneg_rows == 1, "bounds: one inequality kept");
+	int col = find(info.col_map, 2);
+	check(col >= 0, "bounds: bounded column kept");
+	if (col >= 0) {
+		check(approx(info.col_lb[col], 1) && approx(info.col_ub[col], 4),
+		      "bounds: col_lb and col_ub");
+	}
+	col = find(info.col_map, 3);
+	check(col >= 0 && std::isinf(info.col_lb[col]) &&
+	      std::isinf(info.col_ub[col]), "bounds: free column unbounded");
+	check(find(info.row_map, 5) == (int) info.row_map.size() - 1,
+	      "bounds: rows of other cones kept last");
+}
+
+static void test_infeasible() {
+	/* Empty equality row with a nonzero constant */
+	ProblemData empty_row;
+	add(empty_row, 0, 0, 1);
+	double b[] = {-1, 3};
+	empty_row.const_vec.assign(b, b + 2);
+	check(presolve(empty_row, 2, 0, -1, 1e-9).status == PRESOLVE_INFEASIBLE,
+	      "infeasible: empty equality row");
+
+	/* x0 = 1 and x0 = 2 */
+	ProblemData conflict;
+	add(conflict, 0, 0, 1);
+	add(conflict, 1, 0, 1);
+	double c[] = {-1, -2};
+	conflict.const_vec.assign(c, c + 2);
+	check(presolve(conflict, 2, 0, -1, 1e-9).status == PRESOLVE_INFEASIBLE,
+	      "infeasible: conflicting fixings");
+
+	/* x0 >= 3 and x0 <= 1 */
+	ProblemData crossed;
+	add(crossed, 0, 0, -1);
+	add(crossed, 1, 0, 1);
+	double d[] = {3, -1};
+	crossed.const_vec.assign(d, d + 2);
+	check(presolve(crossed, 0, 2, -1, 1e-9).status == PRESOLVE_INFEASIBLE,
+	      "infeasible: crossed bounds");
+}
+
+static void test_objective_offset() {
+	ProblemData data = chain_problem();
+	PresolveInfo info = presolve(data, 2, 3, 5, 1e-9);
+
+	/* 0.25 + 1 * 2 + 2 * 3 */
+	check(approx(data.obj_offset, 8.25), "objective: offset");
+	check(data.obj_vec.size() == info.col_map.size(),
+	      "objective: one entry per kept column");
+	for (unsigned k = 0; k < info.col_map.size(); k++) {
+		double c[] = {1, 2, 0.5, 0, 0};
+		check(data.obj_vec[k] == c[info.col_map[k]],
+		      "objective: entries follow col_map");
+	}
+}
+
+static void test_postsolve() {
+	ProblemData orig = chain_problem();
+	ProblemData data = orig;
+	PresolveInfo info = presolve(data, 2, 3, 5, 1e-9);
+
+	/* A point of the reduced problem: x2 = 2, x3 = -2, x4 = -1 satisfy
+	   row 4 (3 + x3 + x4 <= 0) and the bounds on x2 */
+	std::vector<double> x(info.col_map.size());
+	for (unsigned k = 0; k < x.size(); k++) {
+		double values[] = {0, 0, 2, -2, -1};
+		x[k] = values[info.col_map[k]];
+	}
+	for (unsigned i = 0; i < info.row_map.size(); i++) {
+		check(row_value(data, i, x) <= 1e-12, "postsolve: reduced point");
+	}
+
+	std::vector<double> full = postsolve(info, x);
+	check(full.size() == 5, "postsolve: original length");
+	check(approx(row_value(orig, 0, full), 0) &&
+	      approx(row_value(orig, 1, full), 0), "postsolve: equalities");
+	for (int i = 2; i < 5; i++) {
+		check(row_value(orig, i, full) <= 1e-12, "postsolve: inequalities");
+	}
+	double objective = orig.obj_offset;
+	for (int j = 0; j < 5; j++) {
+		objective += orig.obj_vec[j] * full[j];
+	}
+	double reduced = data.obj_offset;
+	for (unsigned k = 0; k < x.size(); k++) {
+		reduced += data.obj_vec[k] * x[k];
+	}
+	check(approx(objective, reduced), "postsolve: objective value");
+}
+
+static void test_find_parallel_rows() {
+	/* Row 1 is 3 times row 0, row 2 has the same pattern but is not
+	   parallel, and row 3 is empty */
+	ProblemData data;
+	add(data, 0, 0, 1);
+	add(data, 0, 1, 2);
+	add(data, 1, 0, 3);
+	add(data, 1, 1, 6);
+	add(data, 2, 0, 1);
+	add(data, 2, 1, 1);
+	data.const_vec.assign(4, 0);
+	ParallelRows parallel = find_parallel_rows(data, 1e-9);
+	check(parallel.num_parallel == 1, "parallel: one grouped row");
+	check(parallel.representative[0] == -1 &&
+	      parallel.representative[1] == 0 &&
+	      parallel.representative[2] == -1 &&
+	      parallel.representative[3] == -1, "parallel: representatives");
+	check(approx(parallel.ratio[1], 3), "parallel: ratio");
+}
+
+static void test_parallel_rows_large_ratios() {
+	/* Ratios far beyond the range of a long once scaled by 1 / tol, with
+	   rows 0 and 1 parallel and row 2 differing in its last entry */
+	ProblemData data;
+	add(data, 0, 0, 1e-200);
+	add(data, 0, 1, 1);
+	add(data, 0, 2, -1e200);
+	add(data, 1, 0, 2e-200);
+	add(data, 1, 1, 2);
+	add(data, 1, 2, -2e200);
+	add(data, 2, 0, 1e-200);
+	add(data, 2, 1, 1);
+	add(data, 2, 2, 1e200);
+	data.const_vec.assign(3, 0);
+	ParallelRows parallel = find_parallel_rows(data, 1e-9);
+	check(parallel.num_parallel == 1 && parallel.representative[1] == 0 &&
+	      parallel.representative[2] == -1, "parallel: large ratios");
+	check(approx(parallel.ratio[1], 2), "parallel: large ratio");
+}
+
+static void test_merge_parallel_rows() {
+	/* Rows
+	 *
+	 *     0 (zero):     x0 + 2 x1 - 1
+	 *     1 (zero):     2 x0 + 4 x1 - 2     duplicate of row 0
+	 *     2 (nonneg):   x0 + 2 x1 - 5       implied by row 0
+	 *     3 (nonneg):   x2 - 1              x2 <= 1
+	 *     4 (nonneg):   2 x2 - 4            x2 <= 2, looser than row 3
+	 *
+	 * over six columns, of which x3, x4 and x5 are empty. */
+	ProblemData data;
+	add(data, 0, 0, 1);
+	add(data, 0, 1, 2);
+	add(data, 1, 0, 2);
+	add(data, 1, 1, 4);
+	add(data, 2, 0, 1);
+	add(data, 2, 1, 2);
+	add(data, 3, 2, 1);
+	add(data, 4, 2, 2);
+	double b[] = {-1, -2, -5, -1, -4};
+	data.const_vec.assign(b, b + 5);
+	PresolveInfo info = merge_parallel_rows(data, 2, 3, 6, 1e-9);
+	check(info.status == PRESOLVE_OK, "merge: status");
+	check(info.row_map.size() == 2 && info.row_map[0] == 0 &&
+	      info.row_map[1] == 3, "merge: kept rows");
+	check(info.num_zero_rows == 1 && info.num_nonneg_rows == 1,
+	      "merge: row sections");
+	check(info.orig_cols == 6 && info.col_map.size() == 6,
+	      "merge: trailing empty columns kept");
+
+	/* The objective may be longer than the last column of the matrix */
+	ProblemData with_obj;
+	add(with_obj, 0, 0, 1);
+	with_obj.const_vec.assign(1, 0);
+	with_obj.obj_vec.assign(7, 1);
+	info = merge_parallel_rows(with_obj, 1, 0, -1, 1e-9);
+	check(info.orig_cols == 7 && info.col_value.size() == 7,
+	      "merge: columns of the objective kept");
+
+	/* x0 = 1 and 2 x0 = 4 */
+	ProblemData conflict;
+	add(conflict, 0, 0, 1);
+	add(conflict, 1, 0, 2);
+	double c[] = {-1, -4};
+	conflict.const_vec.assign(c, c + 2);
+	check(merge_parallel_rows(conflict, 2, 0, -1, 1e-9).status ==
+	      PRESOLVE_INFEASIBLE, "merge: conflicting equalities");
+}
+
+int main() {
+	test_singleton_propagation();
+	test_inequality_bounds();
+	test_infeasible();
+	test_objective_offset();
+	test_postsolve();
+	test_find_parallel_rows();
+	test_parallel_rows_large_ratios();
+	test_merge_parallel_rows();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_presolve: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,321 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for the passes in ProblemDataOperations.hpp against a dense
+ * reference. Exits with a nonzero status if a check fails. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include "CVXcanon.hpp"
+#include "LinOpForest.hpp"
+#include "ProblemDataOperations.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static bool approx(double a, double b) {
+	return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b));
+}
+
+static bool approx(const std::vector<double> &a, const std::vector<double> &b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (unsigned i = 0; i < a.size(); i++) {
+		if (!approx(a[i], b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static const int ROWS = 50;
+static const int COLS = 40;
+
+/* Row major ROWS x COLS matrix */
+typedef std::vector<double> Dense;
+
+/* Fills DATA with NNZ random entries in multiples of 0.25, so that sums of
+ * duplicates are exact and some of them cancel to zero, and returns their
+ * dense sum */
+template <typename Scalar>
+static Dense random_entries(ProblemDataT<Scalar> &data, int nnz) {
+	Dense A(ROWS * COLS, 0);
+	for (int k = 0; k < nnz; k++) {
+		int i = rand() % ROWS;
+		int j = rand() % COLS;
+		double v = (rand() % 9 - 4) * 0.25;
+		data.I.push_back(i);
+		data.J.push_back(j);
+		data.V.push_back(static_cast<Scalar>(v));
+		A[i * COLS + j] += v;
+	}
+	data.const_vec.assign(ROWS, 0);
+	return A;
+}
+
+/* Returns the dense sum of the entries of DATA */
+template <typename Scalar>
+static Dense to_dense(const ProblemDataT<Scalar> &data) {
+	Dense A(ROWS * COLS, 0);
+	for (unsigned long k = 0; k < data.V.size(); k++) {
+		A[data.I[k] * COLS + data.J[k]] += data.V[k];
+	}
+	return A;
+}
+
+/* True if the entries of DATA are sorted by column, then row, without
+ * duplicates */
+template <typename Scalar>
+static bool is_csc(const ProblemDataT<Scalar> &data) {
+	for (unsigned long k = 1; k < data.V.size(); k++) {
+		if (data.J[k] < data.J[k - 1] ||
+		    (data.J[k] == data.J[k - 1] && data.I[k] <= data.I[k - 1])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename Scalar>
+static void check_canonicalize(int nnz, double zero_tol, const char *what) {
+	ProblemDataT<Scalar> data;
+	Dense A = random_entries(data, nnz);
+	for (unsigned i = 0; i < A.size(); i++) {
+		if (std::fabs(A[i]) <= zero_tol) {
+			A[i] = 0;
+		}
+	}
+	canonicalize(data, zero_tol);
+
+	bool above_tol = true;
+	for (unsigned long k = 0; k < data.V.size(); k++) {
+		above_tol = above_tol && std::fabs(data.V[k]) > zero_tol;
+	}
+	check(data.I.size() == data.V.size() && data.J.size() == data.V.size(),
+	      what);
+	check(is_csc(data), what);
+	check(above_tol, what);
+	check(to_dense(data) == A, what);
+}
+
+static void test_canonicalize() {
+	srand(1);
+	check_canonicalize<double>(0, 0, "canonicalize: empty");
+	check_canonicalize<double>(300, 0, "canonicalize: few duplicates");
+	check_canonicalize<double>(100000, 0, "canonicalize: many duplicates");
+	check_canonicalize<double>(100000, 0.5, "canonicalize: zero_tol");
+	check_canonicalize<float>(100000, 0, "canonicalize: float");
+	check_canonicalize<float>(300, 0.5, "canonicalize: float zero_tol");
+}
+
+/* Returns the statistics of the dense matrix A */
+static MatrixStats dense_stats(const Dense &A) {
+	MatrixStats stats;
+	stats.reset(ROWS);
+	stats.reserve_cols(COLS);
+	for (int i = 0; i < ROWS; i++) {
+		for (int j = 0; j < COLS; j++) {
+			double v = A[i * COLS + j];
+			if (v != 0) {
+				stats.add_entry(i, j, v);
+			}
+		}
+	}
+	for (int i = 0; i < ROWS; i++) {
+		stats.row_norm_two[i] = std::sqrt(stats.row_norm_two[i]);
+	}
+	for (int j = 0; j < COLS; j++) {
+		stats.col_norm_two[j] = std::sqrt(stats.col_norm_two[j]);
+	}
+	return stats;
+}
+
+static bool stats_equal(const MatrixStats &stats, const MatrixStats &ref) {
+	return approx(stats.row_norm_inf, ref.row_norm_inf) &&
+	       approx(stats.row_norm_two, ref.row_norm_two) &&
+	       stats.row_nnz == ref.row_nnz &&
+	       approx(stats.col_norm_inf, ref.col_norm_inf) &&
+	       approx(stats.col_norm_two, ref.col_norm_two) &&
+	       stats.col_nnz == ref.col_nnz;
+}
+
+/* Returns the factors 1 / sqrt(|A_i|_inf) of the rows of A, or of its
+   columns if COLUMNS is set, with 1 for empty ones */
+static std::vector<double> ruiz_factors(const Dense &A, bool columns) {
+	int n = columns ? COLS : ROWS;
+	std::vector<double> factors(n);
+	for (int k = 0; k < n; k++) {
+		double norm = 0;
+		for (int l = 0; l < (columns ? ROWS : COLS); l++) {
+			norm = std::max(norm, std::fabs(columns ? A[l * COLS + k]
+			                                        : A[k * COLS + l]));
+		}
+		factors[k] = norm > 0 ? 1 / std::sqrt(norm) : 1;
+	}
+	return factors;
+}
+
+/* Returns diag(R) A diag(C) */
+static Dense scale(const Dense &A, const std::vector<double> &R,
+                   const std::vector<double> &C) {
+	Dense B(A);
+	for (int i = 0; i < ROWS; i++) {
+		for (int j = 0; j < COLS; j++) {
+			B[i * COLS + j] *= R[i] * C[j];
+		}
+	}
+	return B;
+}
+
+static void test_compute_stats() {
+	ProblemData data;
+	Dense A = random_entries(data, 1000);
+	canonicalize(data, 0);
+	compute_stats(data);
+	check(stats_equal(data.stats, dense_stats(A)), "compute_stats");
+	check(data.stats.row_scale.empty() && data.stats.col_scale.empty(),
+	      "compute_stats: no scaling");
+}
+
+/* Builds A x + b for a random sparse A through build_matrix with OPTIONS,
+   and returns A and b */
+static ProblemData build_random(const BuildOptions &options, Dense &A,
+                                std::vector<double> &b) {
+	A.assign(ROWS * COLS, 0);
+	std::vector<Triplet> triplets;
+	for (int k = 0; k < 400; k++) {
+		int i = rand() % ROWS;
+		int j = rand() % COLS;
+		double v = (rand() % 9 - 4) * 0.25;
+		if (v != 0 && A[i * COLS + j] == 0) {
+			A[i * COLS + j] = v;
+			triplets.push_back(Triplet(i, j, v));
+		}
+	}
+	Matrix sparse_A(ROWS, COLS);
+	sparse_A.setFromTriplets(triplets.begin(), triplets.end());
+	Eigen::MatrixXd dense_b = Eigen::MatrixXd::Random(ROWS, 1);
+	b.assign(dense_b.data(), dense_b.data() + ROWS);
+
+	LinOpForest forest;
+	LinOp *x = forest.variable(0, COLS, 1);
+	forest.add_constraint(forest.sum(forest.mul(sparse_A, x),
+	                                 forest.dense_const(dense_b)));
+	std::map<int, int> id_to_col;
+	id_to_col[0] = 0;
+	return build_matrix(forest.constraints, id_to_col, std::vector<int>(),
+	                    options);
+}
+
+static void test_build_stats() {
+	/* Accumulated during the build, and recomputed after canonicalize */
+	for (int canon = 0; canon < 2; canon++) {
+		BuildOptions options;
+		options.compute_stats = true;
+		options.canonicalize = canon == 1;
+		Dense A;
+		std::vector<double> b;
+		ProblemData data = build_random(options, A, b);
+		check(stats_equal(data.stats, dense_stats(A)), canon
+		      ? "build stats: canonicalize" : "build stats: during the build");
+	}
+}
+
+static void test_equilibrate() {
+	ProblemData data;
+	Dense A = random_entries(data, 1000);
+	std::vector<double> b(ROWS);
+	for (int i = 0; i < ROWS; i++) {
+		b[i] = data.const_vec[i] = i - 20;
+	}
+	canonicalize(data, 0);
+	MatrixStats unscaled = dense_stats(A);
+
+	std::vector<double> R1 = ruiz_factors(A, false);
+	std::vector<double> C1 = ruiz_factors(A, true);
+	Dense A1 = scale(A, R1, C1);
+	equilibrate(data);
+	check(approx(to_dense(data), A1), "equilibrate: matrix");
+	std::vector<double> b1(ROWS);
+	for (int i = 0; i < ROWS; i++) {
+		b1[i] = R1[i] * b[i];
+	}
+	check(approx(data.const_vec, b1), "equilibrate: const_vec");
+	check(stats_equal(data.stats, unscaled),
+	      "equilibrate: stats of the unscaled matrix");
+	check(approx(data.stats.row_scale, R1) && approx(data.stats.col_scale, C1),
+	      "equilibrate: scaling");
+
+	/* A second step scales the scaled matrix and composes the factors */
+	std::vector<double> R2 = ruiz_factors(A1, false);
+	std::vector<double> C2 = ruiz_factors(A1, true);
+	equilibrate(data);
+	check(approx(to_dense(data), scale(A1, R2, C2)),
+	      "equilibrate twice: matrix");
+	for (int i = 0; i < ROWS; i++) {
+		R2[i] *= R1[i];
+	}
+	for (int j = 0; j < COLS; j++) {
+		C2[j] *= C1[j];
+	}
+	check(approx(data.stats.row_scale, R2) && approx(data.stats.col_scale, C2),
+	      "equilibrate twice: scaling");
+	check(approx(to_dense(data), scale(A, R2, C2)),
+	      "equilibrate twice: total scaling");
+}
+
+static void test_build_equilibrate() {
+	BuildOptions options;
+	options.equilibrate = true;
+	Dense A;
+	std::vector<double> b;
+	ProblemData data = build_random(options, A, b);
+	std::vector<double> R = ruiz_factors(A, false);
+	std::vector<double> C = ruiz_factors(A, true);
+	check(approx(to_dense(data), scale(A, R, C)),
+	      "build equilibrate: matrix");
+	for (int i = 0; i < ROWS; i++) {
+		b[i] *= R[i];
+	}
+	check(approx(data.const_vec, b), "build equilibrate: const_vec");
+	check(stats_equal(data.stats, dense_stats(A)),
+	      "build equilibrate: stats of the unscaled matrix");
+}
+
+int main() {
+	test_canonicalize();
+	test_compute_stats();
+	test_build_stats();
+	test_equilibrate();
+	test_build_equilibrate();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_problem_data: all checks passed\n");
+	return 0;
+}
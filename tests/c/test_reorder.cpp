@@ -0,0 +1,142 @@
+/*    This file is part of CVXcanon.
+ *
+ *    CVXcanon is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    CVXcanon is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with CVXcanon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for reorder in Reorder.hpp. Exits with a nonzero status if a check
+ * fails. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Reorder.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/* Returns A x + b for the problem data DATA */
+static std::vector<double> evaluate(const ProblemData &data,
+                                    const std::vector<double> &x) {
+	std::vector<double> result(data.const_vec.begin(), data.const_vec.end());
+	for (unsigned long k = 0; k < data.V.size(); k++) {
+		result[data.I[k]] += data.V[k] * x[data.J[k]];
+	}
+	return result;
+}
+
+static bool is_permutation(const std::vector<int> &perm, int n) {
+	std::vector<int> sorted(perm);
+	std::sort(sorted.begin(), sorted.end());
+	for (int i = 0; i < n; i++) {
+		if ((int) sorted.size() != n || sorted[i] != i) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* A chain of N rows over shuffled columns, with NUM_EXTRA trailing rows in
+ * another cone, and an objective */
+static ProblemData chain_problem(int n, int num_extra) {
+	std::vector<int> cols(n + 1);
+	for (int j = 0; j <= n; j++) {
+		cols[j] = j;
+	}
+	srand(1);
+	for (int j = n; j > 0; j--) {
+		std::swap(cols[j], cols[rand() % (j + 1)]);
+	}
+
+	ProblemData data;
+	for (int i = 0; i < n; i++) {
+		data.I.push_back(i);
+		data.J.push_back(cols[i]);
+		data.V.push_back(1 + i);
+		data.I.push_back(i);
+		data.J.push_back(cols[i + 1]);
+		data.V.push_back(-1);
+	}
+	for (int i = n; i < n + num_extra; i++) {
+		data.I.push_back(i);
+		data.J.push_back(cols[i - n]);
+		data.V.push_back(0.5);
+	}
+	for (int i = 0; i < n + num_extra; i++) {
+		data.const_vec.push_back(i % 7 - 3);
+	}
+	for (int j = 0; j <= n; j++) {
+		data.obj_vec.push_back(j % 5);
+	}
+	return data;
+}
+
+static void test_reorder(ReorderMethod method, const char *name) {
+	int n = 60, num_extra = 5, num_zero = 20, num_nonneg = 40;
+	ProblemData orig = chain_problem(n, num_extra);
+	ProblemData data = orig;
+	Reordering perm = reorder(data, num_zero, num_nonneg, -1, method);
+	int num_rows = n + num_extra;
+	int num_cols = n + 1;
+
+	check(is_permutation(perm.row_perm, num_rows), name);
+	check(is_permutation(perm.col_perm, num_cols), name);
+
+	/* Rows stay within their sections, and other cones do not move */
+	for (int i = 0; i < num_rows; i++) {
+		bool ok = i < num_zero ? perm.row_perm[i] < num_zero
+		          : i < num_zero + num_nonneg
+		          ? perm.row_perm[i] >= num_zero &&
+		            perm.row_perm[i] < num_zero + num_nonneg
+		          : perm.row_perm[i] == i;
+		check(ok, name);
+	}
+
+	/* Row i of the reordered A x + b is row ROW_PERM[i] of the original
+	   at the same point, and the objective follows the columns */
+	std::vector<double> x(num_cols);
+	for (int j = 0; j < num_cols; j++) {
+		x[j] = std::sin(1.0 + j);
+	}
+	std::vector<double> x_orig = perm.restore_cols(x);
+	std::vector<double> y = evaluate(data, x);
+	std::vector<double> y_orig = evaluate(orig, x_orig);
+	for (int i = 0; i < num_rows; i++) {
+		check(std::fabs(y[i] - y_orig[perm.row_perm[i]]) < 1e-12, name);
+	}
+	double obj = 0, obj_orig = 0;
+	for (int j = 0; j < num_cols; j++) {
+		obj += data.obj_vec[j] * x[j];
+		obj_orig += orig.obj_vec[j] * x_orig[j];
+	}
+	check(std::fabs(obj - obj_orig) < 1e-12, name);
+}
+
+int main() {
+	test_reorder(REORDER_RCM, "RCM");
+	test_reorder(REORDER_COLAMD, "COLAMD");
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("test_reorder: all checks passed\n");
+	return 0;
+}
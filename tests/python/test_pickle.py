@@ -0,0 +1,161 @@
+import pickle
+import unittest
+
+import numpy as np
+import scipy.sparse as sp
+
+import CVXcanon
+
+
+def lin_op(ty, size, args=(), dense=None, sparse=None):
+    '''Builds a C++ LinOp of type TY and SIZE over the C++ LinOps ARGS.'''
+    lin = CVXcanon.LinOp()
+    lin.type = ty
+    lin.size.push_back(size[0])
+    lin.size.push_back(size[1])
+    for arg in args:
+        lin.args.push_back(arg)
+    if dense is not None:
+        lin.set_dense_data(np.asfortranarray(np.atleast_2d(dense), dtype=float))
+    if sparse is not None:
+        coo = sp.coo_matrix(sparse)
+        lin.set_sparse_data(coo.data, coo.row.astype(float),
+                            coo.col.astype(float), coo.shape[0], coo.shape[1])
+    # The C++ tree only holds raw pointers to its arguments
+    lin._args = list(args)
+    return lin
+
+
+def variable(var_id, rows, cols=1):
+    return lin_op(CVXcanon.VARIABLE, (rows, cols), dense=[[var_id]])
+
+
+def constraints():
+    '''A x + y == b and -y <= 0, with a sparse A.'''
+    np.random.seed(0)
+    A = sp.random(6, 4, density=0.5, random_state=0)
+    x = variable(0, 4)
+    y = variable(1, 6)
+    b = lin_op(CVXcanon.DENSE_CONST, (6, 1), dense=np.random.randn(6, 1))
+    Ax = lin_op(CVXcanon.MUL, (6, 1), [x], sparse=A)
+    eq = lin_op(CVXcanon.SUM, (6, 1), [Ax, y, b])
+    ineq = lin_op(CVXcanon.NEG, (6, 1), [y])
+    return [eq, ineq]
+
+
+def lin_vector(lins):
+    vec = CVXcanon.LinOpVector()
+    for lin in lins:
+        vec.push_back(lin)
+    return vec
+
+
+def build(lins, build_matrix=CVXcanon.build_matrix, **options):
+    opts = CVXcanon.BuildOptions()
+    for name, value in options.items():
+        setattr(opts, name, value)
+    return build_matrix(lin_vector(lins), CVXcanon.IntIntMap(),
+                        CVXcanon.IntVector(), opts)
+
+
+def matrix(prob):
+    nnz = prob.get_nnz()
+    return (prob.getV(nnz), prob.getI(nnz), prob.getJ(nnz),
+            prob.getConstVec(len(prob.const_vec)))
+
+
+class TestPickle(unittest.TestCase):
+    def assertProblemEqual(self, prob, copy):
+        for orig, new in zip(matrix(prob), matrix(copy)):
+            self.assertTrue(np.array_equal(orig, new))
+        self.assertEqual(dict(prob.id_to_col.items()),
+                         dict(copy.id_to_col.items()))
+        self.assertEqual(dict(prob.const_to_row.items()),
+                         dict(copy.const_to_row.items()))
+        self.assertEqual(bool(prob.sparse_const), bool(copy.sparse_const))
+        self.assertEqual(list(prob.const_idx), list(copy.const_idx))
+        self.assertEqual(list(prob.const_val), list(copy.const_val))
+        for name in CVXcanon._STATS_NORMS + CVXcanon._STATS_COUNTS:
+            self.assertEqual(list(getattr(prob.stats, name)),
+                             list(getattr(copy.stats, name)))
+
+    def round_trips(self, obj):
+        '''Pickles OBJ with every protocol, and with protocol 5 also with
+        out-of-band buffers. Returns the copies.'''
+        copies = []
+        for protocol in range(pickle.HIGHEST_PROTOCOL + 1):
+            copies.append(pickle.loads(pickle.dumps(obj, protocol)))
+        if pickle.HIGHEST_PROTOCOL >= 5:
+            buffers = []
+            data = pickle.dumps(obj, 5, buffer_callback=buffers.append)
+            self.assertTrue(len(buffers) > 0)
+            copies.append(pickle.loads(data, buffers=buffers))
+        return copies
+
+    def test_problem_data(self):
+        prob = build(constraints(), compute_stats=True)
+        self.assertTrue(len(prob.stats.row_nnz) > 0)
+        for copy in self.round_trips(prob):
+            self.assertIs(type(copy), CVXcanon.ProblemData)
+            self.assertProblemEqual(prob, copy)
+
+    def test_sparse_const_vec(self):
+        prob = build(constraints(), sparse_const_vec=True)
+        self.assertTrue(prob.sparse_const and len(prob.const_idx) > 0)
+        for copy in self.round_trips(prob):
+            self.assertProblemEqual(prob, copy)
+
+    def test_problem_data_float(self):
+        prob = build(constraints(), CVXcanon.build_matrix_float,
+                     compute_stats=True)
+        for copy in self.round_trips(prob):
+            self.assertIs(type(copy), CVXcanon.ProblemDataFloat)
+            self.assertProblemEqual(prob, copy)
+
+    def test_out_of_band_buffers_outlive_problem(self):
+        prob = build(constraints())
+        V = matrix(prob)[0]
+        buffers = []
+        data = pickle.dumps(prob, 5, buffer_callback=buffers.append)
+        del prob
+        copy = pickle.loads(data, buffers=buffers)
+        self.assertTrue(np.array_equal(V, matrix(copy)[0]))
+
+    def test_cone_problem_data(self):
+        cones = CVXcanon.IntVector()
+        cones.push_back(CVXcanon.CONE_ZERO)
+        cones.push_back(CVXcanon.CONE_NONNEG)
+        opts = CVXcanon.BuildOptions()
+        opts.compute_stats = True
+        cone = CVXcanon.build_cone_matrix(lin_vector(constraints()), cones,
+                                          CVXcanon.IntIntMap(), opts)
+        for copy in self.round_trips(cone):
+            self.assertIs(type(copy), CVXcanon.ConeProblemData)
+            self.assertProblemEqual(cone.eq, copy.eq)
+            self.assertProblemEqual(cone.ineq, copy.ineq)
+            self.assertEqual(list(cone.cone_rows), list(copy.cone_rows))
+            self.assertEqual([list(s) for s in cone.cone_sizes],
+                             [list(s) for s in copy.cone_sizes])
+
+    def test_deep_lin_op_tree(self):
+        # Deeper than the default recursion limit of the pickler
+        depth = 5000
+        root = variable(0, 3, 2)
+        for _ in range(depth):
+            root = lin_op(CVXcanon.NEG, (3, 2), [root])
+        prob = build([root])
+        for copy in self.round_trips(root):
+            self.assertProblemEqual(prob, build([copy]))
+
+    def test_shared_lin_op_nodes(self):
+        x = variable(0, 4)
+        A = lin_op(CVXcanon.MUL, (4, 1), [x], dense=np.arange(16.0).reshape(4, 4))
+        root = lin_op(CVXcanon.SUM, (4, 1), [A, A])
+        prob = build([root])
+        for copy in self.round_trips(root):
+            self.assertEqual(int(copy.args[0].this), int(copy.args[1].this))
+            self.assertProblemEqual(prob, build([copy]))
+
+
+if __name__ == '__main__':
+    unittest.main()